@@ -1140,6 +1140,20 @@ void QAbstractKineticScroller::setScrollsPerSecond(int sps)
     d->scrollsPerSecond = qBound(1, sps, 100);
 }
 
+/*!
+    Returns the current scroll velocity in pixels per scroll (frame).
+
+    The scroll position is moved by -velocity() on every scroll while
+    the scroller is in the AutoScrolling state.
+
+    \sa scrollsPerSecond()
+*/
+QPointF QAbstractKineticScroller::velocity() const
+{
+    Q_D(const QAbstractKineticScroller);
+    return d->velocity;
+}
+
 
 /*!
     Starts scrolling the widget so that the point \a pos is visible inside
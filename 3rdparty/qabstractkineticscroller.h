@@ -123,6 +123,8 @@ public:
     int scrollsPerSecond() const;
     void setScrollsPerSecond(int sps);
 
+    QPointF velocity() const;
+
     void scrollTo(const QPoint &pos);
     void ensureVisible(const QPoint &pos, int xmargin = 50, int ymargin = 50);
 
@@ -35,25 +35,40 @@ HEADERS = \
   src/BrowsingView.h \
   src/CommonGestureRecognizer.h \
   src/CookieJar.h \
+  src/CookieStore.h \
+  src/DiskCache.h \
   src/EnvHttpProxyFactory.h \
   src/EventHelpers.h \
   src/FontFactory.h \
+  src/FpsOverlayWidget.h \
+  src/FrameStats.h \
   src/Helpers.h \
+  src/HistoryArchive.h \
+  src/HistoryIndex.h \
   src/HistoryStore.h \
   src/HomeView.h \
   src/KeypadWidget.h \
   src/LinkSelectionItem.h \
+  src/LocalSuggestProvider.h \
+  src/NetworkSuggestProvider.h \
   src/PannableTileContainer.h \
   src/PannableViewport.h \
   src/PopupView.h \
+  src/Preconnector.h \
   src/ProgressWidget.h \
   src/ScrollbarItem.h \
   src/Settings.h \
+  src/SuggestProvider.h \
   src/TileContainerWidget.h \
+  src/TileDecorations.h \
   src/TileItem.h \
   src/TileSelectionViewBase.h \
+  src/ThumbnailCache.h \
+  src/ThumbnailWriter.h \
+  src/TiledBackingStorePolicy.h \
   src/ToolbarWidget.h \
   src/UrlItem.h \
+  src/UrlStoreJournal.h \
   src/WebView.h \
   src/WebViewportItem.h \
   src/YberApplication.h \
@@ -70,22 +85,36 @@ SOURCES = \
   src/BrowsingView.cpp \
   src/CommonGestureRecognizer.cpp \
   src/CookieJar.cpp \
+  src/CookieStore.cpp \
+  src/DiskCache.cpp \
   src/EnvHttpProxyFactory.cpp\
   src/EventHelpers.cpp \
   src/FontFactory.cpp \
+  src/FpsOverlayWidget.cpp \
+  src/FrameStats.cpp \
   src/Helpers.cpp \
+  src/HistoryArchive.cpp \
+  src/HistoryIndex.cpp \
   src/HistoryStore.cpp \
   src/HomeView.cpp \
   src/KeypadWidget.cpp \
   src/LinkSelectionItem.cpp \
+  src/LocalSuggestProvider.cpp \
+  src/NetworkSuggestProvider.cpp \
   src/PopupView.cpp \
+  src/Preconnector.cpp \
   src/ProgressWidget.cpp \
   src/ScrollbarItem.cpp \
   src/TileContainerWidget.cpp \
+  src/TileDecorations.cpp \
   src/TileItem.cpp \
   src/TileSelectionViewBase.cpp \
+  src/ThumbnailCache.cpp \
+  src/ThumbnailWriter.cpp \
+  src/TiledBackingStorePolicy.cpp \
   src/ToolbarWidget.cpp \
   src/UrlItem.cpp \
+  src/UrlStoreJournal.cpp \
   src/WebView.cpp \
   src/WebViewportItem.cpp \
   src/YberApplication.cpp \
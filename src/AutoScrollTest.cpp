@@ -28,8 +28,12 @@
 
 #include <QGraphicsWidget>
 #include <QGraphicsScene>
+#include <QPainter>
 #include <QPainterPath>
 #include <QFontMetrics>
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
 
 const int s_scrollPixels[] = {10, 20, 30, 40, 50, 10};
 const int s_scrollPixelsTimeot[] = {3000, 3000, 4000, 4000, 3000, 2000};
@@ -42,12 +46,17 @@ const QColor s_bckColor(20, 20, 20);
 const qreal s_bckTransparency = 0.9;
 const int s_fpsCheckTimeout = 100;
 const int s_scrollTimeout = 10;
+const qreal s_frameBudget = 1000. / 60.;
+const int s_scrollStartDelay = 1000;
 
 AutoScrollTest::AutoScrollTest(PannableViewport* viewport, WebView* webView, QGraphicsItem* parent, Qt::WindowFlags wFlags)
     : QGraphicsWidget(parent, wFlags)
     , m_viewport(viewport)
     , m_webView(webView)
     , m_scrollTimer(this)
+    , m_frameCount(0)
+    , m_pageIndex(0)
+    , m_pageLoaded(false)
 {
     setFlag(QGraphicsItem::ItemClipsChildrenToShape, true);
     setFlag(QGraphicsItem::ItemClipsToShape, true);
@@ -60,19 +69,36 @@ AutoScrollTest::~AutoScrollTest()
 {
 }
 
+void AutoScrollTest::setBenchmarkPages(const QList<QUrl>& pages, const QString& outputFile)
+{
+    m_pages = pages;
+    m_pageIndex = 0;
+    m_outputFile = outputFile;
+    m_frames.clear();
+    // results go to the file, nothing to show on the screen
+    hide();
+    connect(m_webView->page(), SIGNAL(loadFinished(bool)), this, SLOT(loadFinished(bool)));
+}
+
 void AutoScrollTest::starScrollTest()
 {
+    if (isBenchmark() && !m_pageLoaded) {
+        loadNextBenchmarkPage();
+        return;
+    }
+
     // load news.google.com if nothing is loaded.
-    if (m_webView->url().isEmpty()) {
+    if (!isBenchmark() && m_webView->url().isEmpty()) {
         m_webView->load(QUrl("http://news.google.com"));
         connect(m_webView->page(), SIGNAL(loadFinished(bool)), this, SLOT(loadFinished(bool)));
         return;
     }
 
     m_scrollIndex = 0;
-    m_fpsTicks = m_webView->fpsTicks();
+    m_frameCount = m_webView->frameStats().frameCount();
     m_fpsTimestamp.start();
-    m_fpsTimer.start(s_fpsCheckTimeout);
+    if (!isBenchmark())
+        m_fpsTimer.start(s_fpsCheckTimeout);
     m_scrollTimer.start(s_scrollTimeout);   
     m_scrollValue = s_scrollPixels[0];
     QTimer::singleShot(s_scrollPixelsTimeot[0], this, SLOT(scrollTimeout()));
@@ -80,30 +106,46 @@ void AutoScrollTest::starScrollTest()
 
 void AutoScrollTest::doScroll()
 {
-    QPointF position(m_viewport->position().x(), m_viewport->position().y() - m_scrollValue);
+    // keep the content within the viewport, setPosition does not bound it
+    qreal minY = qMin(qreal(0), m_viewport->size().height() - m_viewport->widget()->size().height());
+    qreal y = m_viewport->position().y() - m_scrollValue;
+    QPointF position(m_viewport->position().x(), qBound(minY, y, qreal(0)));
     m_viewport->setPosition(position);
 
     // switch direction
-    if (position.y() != m_viewport->position().y())
+    if (position.y() != y)
         m_scrollValue = -m_scrollValue;
+
+    if (isBenchmark())
+        renderBenchmarkFrame();
 }
 
 void AutoScrollTest::fpsTick()
 {
-    int prevfps = m_fpsTicks;
-    m_fpsTicks = m_webView->fpsTicks();
+    unsigned prevFrameCount = m_frameCount;
+    m_frameCount = m_webView->frameStats().frameCount();
 
     double dt = m_fpsTimestamp.restart();
-    double dticks = m_fpsTicks - prevfps;
+    double dticks = m_frameCount - prevFrameCount;
     if (dt)
         m_fpsValues.append((dticks *  1000.) / dt);
 }
 
 void AutoScrollTest::loadFinished(bool success)
 {
+    if (isBenchmark()) {
+        if (m_pageLoaded)
+            return;
+        if (!success) {
+            qWarning() << "AutoScrollTest: failed to load" << m_pages.value(m_pageIndex);
+            emit benchmarkFinished(false);
+            return;
+        }
+        m_pageLoaded = true;
+    }
     // dont start scrolling right after page is loaded. it alters the result
     if (success)
-        QTimer::singleShot(1000, this, SLOT(starScrollTest()));
+        QTimer::singleShot(s_scrollStartDelay, this, SLOT(starScrollTest()));
 }
 
 void AutoScrollTest::scrollTimeout()
@@ -116,7 +158,179 @@ void AutoScrollTest::scrollTimeout()
     } else {
         m_scrollTimer.stop();
         m_fpsTimer.stop();
-        displayResult();
+        if (!isBenchmark()) {
+            displayResult();
+            return;
+        }
+        // next fixture page or done
+        if (++m_pageIndex < m_pages.size())
+            loadNextBenchmarkPage();
+        else
+            emit benchmarkFinished(writeBenchmarkResult());
+    }
+}
+
+void AutoScrollTest::loadNextBenchmarkPage()
+{
+    m_pageLoaded = false;
+    m_viewport->setPosition(QPointF(0, 0));
+    m_webView->load(m_pages.at(m_pageIndex));
+}
+
+void AutoScrollTest::renderBenchmarkFrame()
+{
+    // render the viewport offscreen, so that no display is needed to measure a frame
+    QRectF source(m_viewport->sceneBoundingRect());
+    if (m_frameBuffer.size() != source.size().toSize())
+        m_frameBuffer = QImage(source.size().toSize(), QImage::Format_RGB32);
+
+    QPainter p(&m_frameBuffer);
+    m_viewport->scene()->render(&p, QRectF(m_frameBuffer.rect()), source);
+    p.end();
+
+    // pick up the paints the web view recorded during the render
+    QVector<FrameStats::Frame> frames;
+    m_frameCount = m_webView->frameStats().frames(m_frameCount, frames);
+    for (int i = 0; i < frames.size(); ++i) {
+        FrameSample sample;
+        sample.page = m_pageIndex;
+        sample.section = m_scrollIndex;
+        sample.time = frames.at(i).duration / 1000.;
+        m_frames.append(sample);
+    }
+}
+
+namespace {
+
+struct FrameSummary {
+    int count;
+    int dropped;
+    qreal p50;
+    qreal p95;
+    qreal p99;
+    qreal max;
+};
+
+qreal percentile(const QList<qreal>& sorted, int p)
+{
+    if (sorted.isEmpty())
+        return 0;
+    // nearest rank
+    int rank = qMax(0, (p * sorted.size() + 99) / 100 - 1);
+    return sorted.at(qMin(rank, sorted.size() - 1));
+}
+
+FrameSummary summarize(QList<qreal> times)
+{
+    FrameSummary summary;
+    qSort(times);
+    summary.count = times.size();
+    summary.dropped = 0;
+    // every budget interval a frame overruns is a frame we did not show
+    for (int i = 0; i < times.size(); ++i)
+        summary.dropped += qMax(0, (int)(times.at(i) / s_frameBudget));
+    summary.p50 = percentile(times, 50);
+    summary.p95 = percentile(times, 95);
+    summary.p99 = percentile(times, 99);
+    summary.max = times.isEmpty() ? 0 : times.last();
+    return summary;
+}
+
+QString jsonString(const QString& str)
+{
+    QString escaped(str);
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"");
+    return "\"" + escaped + "\"";
+}
+
+void writeJsonSummary(QTextStream& out, const FrameSummary& summary)
+{
+    out << "\"frames\": " << summary.count
+        << ", \"dropped\": " << summary.dropped
+        << ", \"p50\": " << summary.p50
+        << ", \"p95\": " << summary.p95
+        << ", \"p99\": " << summary.p99
+        << ", \"max\": " << summary.max;
+}
+
+}
+
+bool AutoScrollTest::writeBenchmarkResult()
+{
+    QFile file(m_outputFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "AutoScrollTest: cannot write" << m_outputFile;
+        return false;
+    }
+    QTextStream out(&file);
+    if (m_outputFile.endsWith(".json", Qt::CaseInsensitive))
+        writeBenchmarkJson(out);
+    else
+        writeBenchmarkCsv(out);
+    return out.status() == QTextStream::Ok;
+}
+
+void AutoScrollTest::writeBenchmarkJson(QTextStream& out)
+{
+    QList<qreal> all;
+    out << "{\n  \"frameBudget\": " << s_frameBudget << ",\n  \"pages\": [\n";
+    for (int page = 0; page < m_pages.size(); ++page) {
+        QList<qreal> times;
+        for (int i = 0; i < m_frames.size(); ++i) {
+            if (m_frames.at(i).page == page)
+                times.append(m_frames.at(i).time);
+        }
+        all += times;
+        out << "    { \"url\": " << jsonString(m_pages.at(page).toString()) << ", ";
+        writeJsonSummary(out, summarize(times));
+        out << ",\n      \"frameTimes\": [";
+        for (int i = 0; i < times.size(); ++i)
+            out << (i ? ", " : "") << times.at(i);
+        out << "] }" << (page < m_pages.size() - 1 ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"total\": { ";
+    writeJsonSummary(out, summarize(all));
+
+    QVector<FrameStats::Frame> frames;
+    for (int i = 0; i < m_frames.size(); ++i) {
+        FrameStats::Frame frame;
+        frame.timestamp = 0;
+        frame.duration = m_frames.at(i).time * 1000;
+        frames.append(frame);
+    }
+    QVector<int> buckets;
+    FrameStats::histogram(frames, buckets);
+    out << ",\n    \"histogram\": [";
+    for (int i = 0; i < buckets.size(); ++i) {
+        qreal bound = FrameStats::bucketUpperBound(i);
+        out << (i ? ", " : "") << "{ \"upTo\": " << (bound < 0 ? QString("null") : QString::number(bound))
+            << ", \"frames\": " << buckets.at(i) << " }";
+    }
+    out << "] }\n}\n";
+}
+
+void AutoScrollTest::writeBenchmarkCsv(QTextStream& out)
+{
+    // per-frame rows, followed by a summary row with section "all" for each page
+    out << "url,section,frame,time,p50,p95,p99,max,dropped\n";
+    QList<qreal> times;
+    int page = -1;
+    for (int i = 0; i <= m_frames.size(); ++i) {
+        if (i == m_frames.size() || m_frames.at(i).page != page) {
+            if (page != -1) {
+                FrameSummary summary = summarize(times);
+                out << m_pages.at(page).toString() << ",all," << summary.count << ",,"
+                    << summary.p50 << "," << summary.p95 << "," << summary.p99 << ","
+                    << summary.max << "," << summary.dropped << "\n";
+            }
+            if (i == m_frames.size())
+                break;
+            page = m_frames.at(i).page;
+            times.clear();
+        }
+        const FrameSample& sample = m_frames.at(i);
+        times.append(sample.time);
+        out << m_pages.at(page).toString() << "," << sample.section << "," << times.size() - 1 << "," << sample.time << ",,,,,\n";
     }
 }
 
@@ -26,8 +26,11 @@
 #include <QTime>
 #include <QTimer>
 #include <QPoint>
+#include <QImage>
+#include <QUrl>
 
 class QGraphicsSceneMouseEvent;
+class QTextStream;
 class PannableViewport;
 class WebView;
 
@@ -38,9 +41,13 @@ public:
     AutoScrollTest(PannableViewport* viewport, WebView* webView, QGraphicsItem* parent = 0, Qt::WindowFlags wFlags = 0);
     ~AutoScrollTest();
 
-    void starScrollTest();
+    // benchmark mode: load the pages one by one, render offscreen and
+    // write the frame timings to outputFile instead of drawing the graph
+    void setBenchmarkPages(const QList<QUrl>& pages, const QString& outputFile);
+    bool isBenchmark() const { return !m_outputFile.isEmpty(); }
 
 public Q_SLOTS:
+    void starScrollTest();
     void doScroll();
     void fpsTick();
     void loadFinished(bool);
@@ -48,8 +55,21 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void finished();
+    void benchmarkFinished(bool success);
 
 private:
+    struct FrameSample {
+        int page;
+        int section;
+        qreal time;
+    };
+
+    void loadNextBenchmarkPage();
+    void renderBenchmarkFrame();
+    bool writeBenchmarkResult();
+    void writeBenchmarkJson(QTextStream&);
+    void writeBenchmarkCsv(QTextStream&);
+
     virtual void mousePressEvent(QGraphicsSceneMouseEvent*);
     void addAreaDividerItem(int);
     void addHorizontalLineItem(int);
@@ -66,10 +86,17 @@ private:
     int m_scrollValue;
     QTime m_fpsTimestamp;
     QTimer m_fpsTimer;
-    unsigned int m_fpsTicks;
+    unsigned m_frameCount;
     QList<int> m_fpsValues;
     int m_min;
     int m_max;
     int m_avg;
+
+    QList<QUrl> m_pages;
+    int m_pageIndex;
+    bool m_pageLoaded;
+    QString m_outputFile;
+    QImage m_frameBuffer;
+    QList<FrameSample> m_frames;
 };
 #endif
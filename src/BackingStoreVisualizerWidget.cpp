@@ -23,23 +23,35 @@
 #if !USE_WEBKIT2
 
 #include <qgraphicswebview.h>
-#include <QTimer>
+#include <qwebpage.h>
+#include <QGraphicsSimpleTextItem>
+#include <QTextStream>
+#include <QDateTime>
 #include <QDebug>
 
-static const unsigned s_tileSize = 35;
+static const QSize s_defaultTileSize(256, 256);
+static const int s_bytesPerPixel = 4;
+static const int s_statsInterval = 1000;
+// churn is reported per this many pixels scrolled
+static const qreal s_churnDistance = 1000;
 
 #define TILE_KEY(x,y) (x << 16 | y)
 
 class BackingStoreTileItem : public QObject {
     Q_OBJECT
 public:
-    BackingStoreTileItem(unsigned hPos, unsigned vPos, QGraphicsItem* parent);
+    BackingStoreTileItem(unsigned hPos, unsigned vPos, const QSize& tileSize, QGraphicsItem* parent);
     ~BackingStoreTileItem();
 
     bool isActive() const;
     void setActive(bool active);
     void painted();
 
+    bool wasSeen() const { return m_seen; }
+    void setSeen() { m_seen = true; }
+    QRectF rect() const { return m_rectItem->rect(); }
+    void setVisible(bool visible) { m_rectItem->setVisible(visible); }
+
 private Q_SLOTS:
     void paintBlinkEnd();
 
@@ -47,16 +59,18 @@ private:
     unsigned           m_vPos;
     unsigned           m_hPos;
     bool               m_active;
+    bool               m_seen;
     unsigned           m_beingPainted;
     QGraphicsRectItem* m_rectItem;
 };
 
-BackingStoreTileItem::BackingStoreTileItem(unsigned hPos, unsigned vPos, QGraphicsItem* parent)
+BackingStoreTileItem::BackingStoreTileItem(unsigned hPos, unsigned vPos, const QSize& tileSize, QGraphicsItem* parent)
     : m_vPos(vPos)
     , m_hPos(hPos)
     , m_active(false)
+    , m_seen(false)
     , m_beingPainted(0)
-    , m_rectItem(new QGraphicsRectItem(hPos*s_tileSize, vPos*s_tileSize, s_tileSize, s_tileSize, parent))
+    , m_rectItem(new QGraphicsRectItem(hPos * tileSize.width(), vPos * tileSize.height(), tileSize.width(), tileSize.height(), parent))
 {
     setActive(true);
 }
@@ -76,6 +90,8 @@ void BackingStoreTileItem::setActive(bool active)
     if (active && m_active)
         qDebug() << "duplicate tile at:" << m_hPos << " " <<  m_vPos;
 
+    if (active && !m_active)
+        m_seen = false;
     m_active = active;
     m_rectItem->setBrush(QBrush(active?Qt::cyan:Qt::gray));
     m_rectItem->setOpacity(0.4);
@@ -102,11 +118,31 @@ void BackingStoreTileItem::paintBlinkEnd()
     m_beingPainted = 0;
 }
 
+/*!
+  \class BackingStoreVisualizerWidget shows the tiles of the tiled backing
+  store and keeps statistics of them.
+
+  The statistics (tiles alive, bytes held, tile creations, removals and
+  paints per second, tiles thrown away without ever being visible and
+  tile churn per scrolled distance) are shown on top of the viewport and
+  can be appended to a log file every second.
+
+  The widget is expected to be a child of the item the web view is
+  scaled to, so that tile coordinates map to its own coordinates.
+*/
 BackingStoreVisualizerWidget::BackingStoreVisualizerWidget(QGraphicsWebView* webView, QGraphicsItem* parent)
     : QGraphicsWidget(parent)
     , m_webView(webView)
+    , m_tilesVisible(true)
+    , m_tilesAlive(0)
+    , m_statsItem(new QGraphicsSimpleTextItem(this))
 {
+    m_statsItem->setBrush(Qt::red);
+    m_statsItem->setZValue(1);
     connectSignals();
+    connect(&m_statsTimer, SIGNAL(timeout()), this, SLOT(updateStats()));
+    m_statsTimer.start(s_statsInterval);
+    m_intervalTime.start();
 }
 
 BackingStoreVisualizerWidget::~BackingStoreVisualizerWidget()
@@ -115,6 +151,70 @@ BackingStoreVisualizerWidget::~BackingStoreVisualizerWidget()
     resetCacheTiles();
 }
 
+void BackingStoreVisualizerWidget::setTilesVisible(bool visible)
+{
+    m_tilesVisible = visible;
+    m_statsItem->setVisible(visible);
+    QMapIterator<int, BackingStoreTileItem*> i(m_tileMap);
+    while (i.hasNext())
+        i.next().value()->setVisible(visible);
+}
+
+void BackingStoreVisualizerWidget::setLogFile(const QString& path)
+{
+    m_logFile.close();
+    if (path.isEmpty())
+        return;
+
+    m_logFile.setFileName(path);
+    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "cannot open tile statistics log" << path;
+        return;
+    }
+    if (!m_logFile.size())
+        QTextStream(&m_logFile) << "time,url,tiles,bytes,created/s,removed/s,painted/s,wasted/s,churn/" << s_churnDistance << "px" << endl;
+}
+
+/*!
+  Updates the part of the contents in the viewport, in the coordinates
+  of the parent item. Movements of the rect count as scroll distance.
+*/
+void BackingStoreVisualizerWidget::setVisibleRect(const QRectF& rect)
+{
+    // zooming is not scrolling
+    if (m_visibleRect.size() == rect.size()) {
+        QPointF delta = rect.topLeft() - m_visibleRect.topLeft();
+        m_interval.scrollDistance += qAbs(delta.x()) + qAbs(delta.y());
+    }
+    m_visibleRect = rect;
+    m_statsItem->setPos(rect.topLeft() + QPointF(5, 5));
+    markVisibleTiles();
+}
+
+void BackingStoreVisualizerWidget::markVisibleTiles()
+{
+    QSize size = tileSize();
+    if (m_visibleRect.isEmpty() || size.isEmpty())
+        return;
+
+    int left = qMax(0, int(m_visibleRect.left()) / size.width());
+    int top = qMax(0, int(m_visibleRect.top()) / size.height());
+    int right = qMax(0, int(m_visibleRect.right()) / size.width());
+    int bottom = qMax(0, int(m_visibleRect.bottom()) / size.height());
+    for (int x = left; x <= right; ++x) {
+        for (int y = top; y <= bottom; ++y) {
+            BackingStoreTileItem* tile = m_tileMap.value(TILE_KEY(x, y));
+            if (tile && tile->isActive())
+                tile->setSeen();
+        }
+    }
+}
+
+QSize BackingStoreVisualizerWidget::tileSize() const
+{
+    QSize size = m_webView->page()->property("_q_TiledBackingStoreTileSize").toSize();
+    return size.isValid() ? size : s_defaultTileSize;
+}
 
 void BackingStoreVisualizerWidget::connectSignals()
 {
@@ -136,17 +236,33 @@ void BackingStoreVisualizerWidget::disconnectSignals()
 void BackingStoreVisualizerWidget::tileCreated(unsigned hPos, unsigned vPos)
 {
     // new tile or just inactive?
-    if (!m_tileMap.contains(TILE_KEY(hPos, vPos)))
-        m_tileMap.insert(TILE_KEY(hPos, vPos), new BackingStoreTileItem(hPos, vPos, this));
+    BackingStoreTileItem* tile = m_tileMap.value(TILE_KEY(hPos, vPos));
+    if (!tile) {
+        tile = new BackingStoreTileItem(hPos, vPos, tileSize(), this);
+        tile->setVisible(m_tilesVisible);
+        m_tileMap.insert(TILE_KEY(hPos, vPos), tile);
+    } else if (tile->isActive())
+        return;
     else
-        m_tileMap.value(TILE_KEY(hPos, vPos))->setActive(true);
+        tile->setActive(true);
+
+    m_tilesAlive++;
+    m_interval.created++;
+    if (m_visibleRect.intersects(tile->rect()))
+        tile->setSeen();
 }
 
 void BackingStoreVisualizerWidget::tileRemoved(unsigned hPos, unsigned vPos)
 {
-    if (!m_tileMap.contains(TILE_KEY(hPos, vPos)))
+    BackingStoreTileItem* tile = m_tileMap.value(TILE_KEY(hPos, vPos));
+    if (!tile || !tile->isActive())
         return;
-    m_tileMap.value(TILE_KEY(hPos, vPos))->setActive(false);
+
+    tile->setActive(false);
+    m_tilesAlive--;
+    m_interval.removed++;
+    if (!tile->wasSeen())
+        m_interval.wasted++;
 }
 
 void BackingStoreVisualizerWidget::tilePainted(unsigned hPos, unsigned vPos)
@@ -154,6 +270,7 @@ void BackingStoreVisualizerWidget::tilePainted(unsigned hPos, unsigned vPos)
     if (!m_tileMap.contains(TILE_KEY(hPos, vPos)))
         tileCreated(hPos, vPos);
     m_tileMap.value(TILE_KEY(hPos, vPos))->painted();
+    m_interval.painted++;
 }
 
 void BackingStoreVisualizerWidget::tileCacheViewportScaleChanged()
@@ -169,6 +286,39 @@ void BackingStoreVisualizerWidget::resetCacheTiles()
         delete i.value();
     }
     m_tileMap.clear();
+    m_tilesAlive = 0;
+}
+
+void BackingStoreVisualizerWidget::updateStats()
+{
+    qreal seconds = qMax(1, m_intervalTime.restart()) / 1000.;
+    QSize size = tileSize();
+    qint64 bytes = qint64(m_tilesAlive) * size.width() * size.height() * s_bytesPerPixel;
+    qreal churn = m_interval.scrollDistance > 0 ? (m_interval.created + m_interval.removed) * s_churnDistance / m_interval.scrollDistance : 0;
+
+    m_statsItem->setText(QString("tiles: %1 (%2 kB)\ncreated: %3/s removed: %4/s painted: %5/s\nwasted: %6/s (total %7 of %8)\nchurn: %9 per %10px")
+                         .arg(m_tilesAlive).arg(bytes / 1024)
+                         .arg(m_interval.created / seconds, 0, 'f', 1).arg(m_interval.removed / seconds, 0, 'f', 1)
+                         .arg(m_interval.painted / seconds, 0, 'f', 1)
+                         .arg(m_interval.wasted / seconds, 0, 'f', 1).arg(m_total.wasted + m_interval.wasted)
+                         .arg(m_total.removed + m_interval.removed)
+                         .arg(churn, 0, 'f', 1).arg(s_churnDistance));
+
+    if (m_logFile.isOpen()) {
+        QTextStream(&m_logFile) << QDateTime::currentDateTime().toString(Qt::ISODate) << ","
+                                << m_webView->url().toString() << ","
+                                << m_tilesAlive << "," << bytes << ","
+                                << m_interval.created / seconds << "," << m_interval.removed / seconds << ","
+                                << m_interval.painted / seconds << "," << m_interval.wasted / seconds << ","
+                                << churn << endl;
+    }
+
+    m_total.created += m_interval.created;
+    m_total.removed += m_interval.removed;
+    m_total.painted += m_interval.painted;
+    m_total.wasted += m_interval.wasted;
+    m_total.scrollDistance += m_interval.scrollDistance;
+    m_interval = Counters();
 }
 
 #include "BackingStoreVisualizerWidget.moc"
@@ -24,9 +24,13 @@
 #if !USE_WEBKIT2
 #include <QGraphicsWidget>
 #include <QMap>
+#include <QFile>
+#include <QTime>
+#include <QTimer>
 #include "yberconfig.h"
 
 class QGraphicsWebView;
+class QGraphicsSimpleTextItem;
 class BackingStoreTileItem;
 
 class BackingStoreVisualizerWidget : public QGraphicsWidget
@@ -37,22 +41,47 @@ public:
     BackingStoreVisualizerWidget(QGraphicsWebView*, QGraphicsItem* parent=0);
     ~BackingStoreVisualizerWidget();
 
+    void setTilesVisible(bool visible);
+    void setLogFile(const QString& path);
+    void setVisibleRect(const QRectF& rect);
+
 protected Q_SLOTS:
     void tileCreated(unsigned hPos, unsigned vPos);
     void tileRemoved(unsigned hPos, unsigned vPos);
     void tilePainted(unsigned hPos, unsigned vPos);
     void tileCacheViewportScaleChanged();
     void resetCacheTiles();
+    void updateStats();
 
 private:
     Q_DISABLE_COPY(BackingStoreVisualizerWidget)
 
     void connectSignals();
     void disconnectSignals();
-    
+    QSize tileSize() const;
+    void markVisibleTiles();
+
+    struct Counters {
+        Counters() : created(0), removed(0), painted(0), wasted(0), scrollDistance(0) {}
+        unsigned created;
+        unsigned removed;
+        unsigned painted;
+        // tiles removed without ever having been in the viewport
+        unsigned wasted;
+        qreal scrollDistance;
+    };
+
     QGraphicsWebView* m_webView;
     QMap<int, BackingStoreTileItem*> m_tileMap;
-
+    bool m_tilesVisible;
+    unsigned m_tilesAlive;
+    QRectF m_visibleRect;
+    Counters m_interval;
+    Counters m_total;
+    QTime m_intervalTime;
+    QTimer m_statsTimer;
+    QFile m_logFile;
+    QGraphicsSimpleTextItem* m_statsItem;
 };
 #endif
 #endif
@@ -20,6 +20,7 @@
 
 #include "BookmarkStore.h"
 #include "Helpers.h"
+#include "ThumbnailWriter.h"
 
 #include <QImage>
 #include <QPixmap>
@@ -27,6 +28,8 @@
 #include <QDebug>
 
 static uint s_currentVersion = 3;
+static const int s_externalizeDelay = 30000;
+static const int s_maxJournalRecords = 50;
 
 BookmarkStore* BookmarkStore::instance()
 {
@@ -37,9 +40,19 @@ BookmarkStore* BookmarkStore::instance()
 }    
 
 BookmarkStore::BookmarkStore()
-    : m_needsPersisting(false)
+    : m_journal("bookmarkstore.journal")
+    , m_needsPersisting(false)
 {
+    m_externalizeTimer.setSingleShot(true);
+    m_externalizeTimer.setInterval(s_externalizeDelay);
+    connect(&m_externalizeTimer, SIGNAL(timeout()), this, SLOT(externalize()));
+
     internalizeUrlList(m_list, "bookmarkstore.txt", s_currentVersion);
+    if (m_journal.replay(m_list)) {
+        // keep the title order
+        qStableSort(m_list.begin(), m_list.end());
+        externalizeSoon();
+    }
     if (!m_list.size()) {
         // FIXME move icons out of the res file. 
         add(QUrl("http://www.facebook.com/"), "Welcome to facebook");
@@ -55,6 +68,7 @@ BookmarkStore::BookmarkStore()
 BookmarkStore::~BookmarkStore()
 {
     externalize();
+    ThumbnailWriter::instance()->flush();
 }
 
 void BookmarkStore::add(const QUrl& url, const QString& title)
@@ -67,8 +81,9 @@ void BookmarkStore::add(const QUrl& url, const QString& title)
         image = 0;
     }
 #endif
-    UrlItem newItem(url, title, 0);
-    m_list.insert(qUpperBound(m_list.begin(), m_list.end(), newItem), newItem);
+    UrlItem newItem(url, title);
+    UrlList::iterator it = m_list.insert(qUpperBound(m_list.begin(), m_list.end(), newItem), newItem);
+    m_journal.itemChanged(*it);
 
     externalizeSoon();
 }
@@ -77,6 +92,7 @@ void BookmarkStore::remove(const QUrl& url)
 {
     for (int i = 0; i < m_list.size(); ++i) {
         if (m_list[i].url() == url) {
+            m_journal.itemRemoved(url);
             m_list.removeAt(i);
             externalizeSoon();
             break;
@@ -87,14 +103,20 @@ void BookmarkStore::remove(const QUrl& url)
 void BookmarkStore::externalizeSoon()
 {
     m_needsPersisting = true;
-    QTimer::singleShot(5000, this, SLOT(externalize()));
+    if (m_journal.records() >= s_maxJournalRecords)
+        externalize();
+    else if (!m_externalizeTimer.isActive())
+        m_externalizeTimer.start();
 }
 
 void BookmarkStore::externalize()
 {
+    m_externalizeTimer.stop();
     if (!m_needsPersisting)
         return;
-    externalizeUrlList(m_list, "bookmarkstore.txt", s_currentVersion);
+    if (!externalizeUrlList(m_list, "bookmarkstore.txt", s_currentVersion))
+        return;
+    m_journal.clear();
     m_needsPersisting = false;
 }
 
@@ -25,7 +25,9 @@
 #include <QList>
 #include <QUrl>
 #include <QIcon>
+#include <QTimer>
 #include "UrlItem.h"
+#include "UrlStoreJournal.h"
 
 class BookmarkStore : public QObject {
     Q_OBJECT
@@ -47,6 +49,8 @@ private Q_SLOTS:
 
 private:
     UrlList m_list;
+    UrlStoreJournal m_journal;
+    QTimer m_externalizeTimer;
     bool m_needsPersisting;
 };
 
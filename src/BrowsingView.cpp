@@ -39,6 +39,8 @@
 #include "BookmarkStore.h"
 #include "AutoScrollTest.h"
 #include "ToolbarWidget.h"
+#include "FpsOverlayWidget.h"
+#include "ThumbnailCache.h"
 #include "qwebframe.h"
 
 #include <QAction>
@@ -63,6 +65,9 @@
 namespace {
 
 const int s_maxWindows = 6;
+const QSizeF s_fpsOverlaySize(200, 80);
+// thumbnails are rendered this wide, about the widest tile
+const int s_thumbnailWidth = 400;
 
 }
 
@@ -77,6 +82,7 @@ BrowsingView::BrowsingView(QGraphicsItem *parent)
     , m_initialHomeWidget(HomeView::VisitedPages)
     , m_toolbarWidget(new ToolbarWidget(this))
     , m_appWin(0)
+    , m_fpsOverlay(0)
 {
     setFlag(QGraphicsItem::ItemClipsToShape, true);
     setFlag(QGraphicsItem::ItemClipsChildrenToShape, true);
@@ -93,6 +99,10 @@ BrowsingView::BrowsingView(QGraphicsItem *parent)
 #if USE_WEBKIT2
     m_context.adopt(WKContextGetSharedProcessContext());
 #endif
+    if (Settings::instance()->FPSEnabled()) {
+        m_fpsOverlay = new FpsOverlayWidget(this);
+        m_fpsOverlay->setZValue(1000);
+    }
 
     // Create and activate new window.
     newWindow();
@@ -159,6 +169,8 @@ void BrowsingView::resizeEvent(QGraphicsSceneResizeEvent* event)
     QRectF r(rect());
     r.setHeight(ToolbarWidget::height());
     m_toolbarWidget->setGeometry(r);
+    if (m_fpsOverlay)
+        m_fpsOverlay->setGeometry(QRectF(QPointF(size().width() - s_fpsOverlaySize.width(), size().height() - s_fpsOverlaySize.height()), s_fpsOverlaySize));
 #if !USE_MEEGOTOUCH
     if (!m_appWin->updatesEnabled()) {
         QSizeF dsz = m_browsingViewport->size() - m_sizeBeforeResize;
@@ -262,6 +274,8 @@ void BrowsingView::setActiveWindow(WebView* webView)
     webView->show();
     m_activeWebView = webView;
     m_browsingViewport->setWebView(webView);
+    if (m_fpsOverlay)
+        m_fpsOverlay->setWebView(webView);
 
     // View background needs to be updated.
     if (m_homeView)
@@ -333,6 +347,8 @@ void BrowsingView::deleteHomeView()
 
     delete m_homeView;
     m_homeView = 0;
+    // the tiles are gone, their thumbnails load fast enough from the raw copies next time
+    ThumbnailCache::instance()->releaseMemory();
 }
 
 void BrowsingView::urlEditingFinished(const QString& url)
@@ -353,17 +369,14 @@ void BrowsingView::urlEditfocusChanged(bool focused)
 void BrowsingView::updateHistoryStore(bool successLoad)
 {
     // render thumbnail
-    QImage* thumbnail = 0;
+    // the levels tiles use are built here, once, not when the home view opens
+    QList<QImage> thumbnail;
     bool exist = HistoryStore::instance()->contains(m_activeWebView->url().toString());
     // update thumbnail even if load failed (cancelled?) when this is the first access.
     bool update = successLoad || !exist;
 
-    if (update) {
-        QGraphicsPixmapItem* pixmapItem = webviewSnapshot(false);
-        if (pixmapItem)
-            thumbnail = new QImage(pixmapItem->pixmap().toImage());
-        delete pixmapItem;
-    }
+    if (update)
+        thumbnail = thumbnailLevels(webviewThumbnail());
     HistoryStore::instance()->accessed(m_activeWebView->url(), m_activeWebView->title(), thumbnail);
 }
 
@@ -379,7 +392,9 @@ void BrowsingView::loadFinished(bool success)
         // address bar to changed the url to the one I was loading.
         urlChanged(m_activeWebView->url());
     }
-    updateHistoryStore(success);
+    // benchmark fixtures do not belong to the user's history
+    if (!Settings::instance()->benchmarkEnabled())
+        updateHistoryStore(success);
 }
 
 void BrowsingView::urlChanged(const QUrl& url)
@@ -445,27 +460,68 @@ void BrowsingView::finishedAutoScrollTest()
     m_autoScrollTest = 0;
 }
 
+void BrowsingView::startScrollBenchmark(const QList<QUrl>& pages, const QString& outputFile)
+{
+    // the home view would end up in the rendered frames
+    deleteHomeView();
+    delete m_autoScrollTest;
+    m_autoScrollTest = new AutoScrollTest(m_browsingViewport, m_activeWebView, this);
+    m_autoScrollTest->resize(rect().size());
+    m_autoScrollTest->setBenchmarkPages(pages, outputFile);
+    connect(m_autoScrollTest, SIGNAL(benchmarkFinished(bool)), this, SLOT(finishedScrollBenchmark(bool)));
+    m_autoScrollTest->starScrollTest();
+}
+
+void BrowsingView::finishedScrollBenchmark(bool success)
+{
+    m_autoScrollTest->deleteLater();
+    m_autoScrollTest = 0;
+    QCoreApplication::exit(success ? 0 : 1);
+}
+
 QGraphicsPixmapItem* BrowsingView::webviewSnapshot(bool darken)
+{
+    QSize snapshotSize = size().toSize();
+    // a new buffer only if the size changed or the last one is still in use
+    if (m_snapshotBuffer.size() != snapshotSize || !m_snapshotBuffer.isDetached())
+        m_snapshotBuffer = QImage(snapshotSize, QImage::Format_RGB32);
+    renderWebview(m_snapshotBuffer, darken);
+    return new QGraphicsPixmapItem(QPixmap::fromImage(m_snapshotBuffer));
+}
+
+/*!
+  Renders the web view straight at thumbnail size, there is no full size
+  image in between.
+*/
+QImage BrowsingView::webviewThumbnail()
 {
     QSizeF thumbnailSize(size());
-    QImage thumbnail(thumbnailSize.width(), thumbnailSize.height(), QImage::Format_RGB32);
+    if (thumbnailSize.width() > s_thumbnailWidth)
+        thumbnailSize *= s_thumbnailWidth / thumbnailSize.width();
+    QImage thumbnail(thumbnailSize.toSize(), QImage::Format_RGB32);
+    renderWebview(thumbnail, false);
+    return thumbnail;
+}
 
-    QPainter p(&thumbnail);
+void BrowsingView::renderWebview(QImage& target, bool darken)
+{
+    QPainter p(&target);
 
     if (m_activeWebView && !m_activeWebView->url().isEmpty()) {
-        qreal scale = m_activeWebView->scale();
+        // the web view paints from its tiled backing store, scaling down the tiles is cheaper than
+        // rendering the page again
+        qreal scale = m_activeWebView->scale() * target.width() / size().width();
         QStyleOptionGraphicsItem sItem;
-        sItem.exposedRect = QRectF(QPointF(0, 0), thumbnailSize/scale);
+        sItem.exposedRect = QRectF(QPointF(0, 0), QSizeF(target.size()) / scale);
+        p.setRenderHint(QPainter::SmoothPixmapTransform, target.width() != size().width());
         p.scale(scale, scale);
         // FIXME until the right api is figured out.
         m_activeWebView->paint(&p, &sItem);
-        //m_activeWebView->page()->mainFrame()->render(&p, QWebFrame::ContentsLayer, QRegion(0, 0, thumbnailSize.width()/scale, thumbnailSize.height()/scale));
+        //m_activeWebView->page()->mainFrame()->render(&p, QWebFrame::ContentsLayer, QRegion(0, 0, target.width()/scale, target.height()/scale));
         if (darken)
             p.fillRect(sItem.exposedRect, QColor(0, 0, 0, 198));
     } else
-        p.fillRect(thumbnail.rect(), QColor(30, 30, 30));
-
-    return new QGraphicsPixmapItem(QPixmap::fromImage(thumbnail));
+        p.fillRect(target.rect(), QColor(30, 30, 30));
 }
 
 
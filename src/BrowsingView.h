@@ -41,6 +41,7 @@ typedef MWidget YberWidget;
 class MTextEdit;
 #else
 #include <QGraphicsWidget>
+#include <QImage>
 #include <QUrl>
 typedef QGraphicsWidget BrowsingViewBase;
 typedef QGraphicsWidget YberWidget;
@@ -56,6 +57,7 @@ class AutoScrollTest;
 class PopupView;
 class QGraphicsPixmapItem;
 class ToolbarWidget;
+class FpsOverlayWidget;
 class QGraphicsProxyWidget;
 class QWebPage;
 
@@ -74,6 +76,8 @@ public:
     void setAttachedWidget(QGraphicsItem*);
     void setOffsetWidget(QGraphicsItem*);
 
+    void startScrollBenchmark(const QList<QUrl>& pages, const QString& outputFile);
+
 public Q_SLOTS:
     void load(const QUrl&);
     WebView* newWindow();
@@ -104,6 +108,7 @@ protected Q_SLOTS:
 
     void startAutoScrollTest();
     void finishedAutoScrollTest();
+    void finishedScrollBenchmark(bool success);
 
     void windowSelected(WebView* webView);
     void windowClosed(WebView* webView);
@@ -119,6 +124,8 @@ private:
     void connectWebViewSignals(WebView* currentView, WebView* oldView);
     void updateHistoryStore(bool successLoad);
     QGraphicsPixmapItem* webviewSnapshot(bool darken = true);
+    QImage webviewThumbnail();
+    void renderWebview(QImage& target, bool darken);
     
 #if !USE_MEEGOTOUCH
     QMenuBar* createMenu(QWidget* parent);
@@ -133,6 +140,9 @@ private:
     HomeView::HomeWidgetType m_initialHomeWidget;
     ToolbarWidget* m_toolbarWidget;
     ApplicationWindow* m_appWin;
+    FpsOverlayWidget* m_fpsOverlay;
+    // home view backgrounds are rendered here, it is free again once turned to a pixmap
+    QImage m_snapshotBuffer;
 #if USE_WEBKIT2
     WKRetainPtr<WKContextRef> m_context;
 #endif
@@ -21,95 +21,234 @@
 #include "CookieJar.h"
 #include "Settings.h"
 
-#include <QFile>
 #include <QDateTime>
 #include <QTimerEvent>
 
-const quint8 cookieFileVersion = 1;
+// changed cookies are written to the log in batches
+static const int s_cookieSavingDelay = 2000;
 
+static QString cookieKey(const QNetworkCookie& cookie)
+{
+    return cookie.domain() + QLatin1Char(';') + cookie.path() + QLatin1Char(';') + QString::fromUtf8(cookie.name());
+}
+
+static bool isSameCookie(const QNetworkCookie& cookie1, const QNetworkCookie& cookie2)
+{
+    return cookie1.name() == cookie2.name() && cookie1.domain() == cookie2.domain() && cookie1.path() == cookie2.path();
+}
+
+// matching rules of QNetworkCookieJar
+static bool isParentDomain(const QString& domain, const QString& reference)
+{
+    if (!reference.startsWith(QLatin1Char('.')))
+        return domain == reference;
+    return domain.endsWith(reference) || domain == reference.mid(1);
+}
+
+static bool isParentPath(QString path, QString reference)
+{
+    if (!path.endsWith(QLatin1Char('/')))
+        path += QLatin1Char('/');
+    if (!reference.endsWith(QLatin1Char('/')))
+        reference += QLatin1Char('/');
+    return path.startsWith(reference);
+}
+
+/*!
+  \class CookieJar keeps the cookies indexed by registrable domain.
+
+  A url only looks at the cookies of its own site instead of the whole
+  jar, expiration goes through the cookies ordered by expiration time.
+  CookieStore persists them and loads them a domain at a time.
+*/
 CookieJar::CookieJar(QObject* parent)
     : QNetworkCookieJar(parent)
-    , m_cookiesChanged(false)
+    , m_store(Settings::instance()->cookieFilePath())
 {
     load();
-    // save cookies every 2 minutes
-    m_cookieSavingTimer.start(1000 * 60 * 2, this);
 }
 
 CookieJar::~CookieJar()
 {
     save();
+    m_store.waitForCompaction();
 }
 
+/*!
+  Writes the changed cookies to the cookie store log. Compacting the log
+  happens off the ui thread.
+*/
 void CookieJar::save()
 {
+    m_cookieSavingTimer.stop();
     expireCookies();
-    if (!m_cookiesChanged)
+    m_store.flush();
+    if (m_store.compactionNeeded())
+        m_store.compact(cookies());
+}
+
+/*!
+  Only the index of the stored cookies is read, the cookies of a domain
+  are loaded when a url of the domain first needs them.
+*/
+void CookieJar::load()
+{
+    m_cookies.clear();
+    m_expiry.clear();
+    m_store.load();
+}
+
+void CookieJar::loadDomain(const QString& domain)
+{
+    if (m_store.isLoaded(domain))
         return;
+    QList<QNetworkCookie> stored = m_store.loadDomain(domain);
+    for (int i = 0; i < stored.size(); ++i)
+        insertCookie(stored.at(i));
+}
 
-    QByteArray cookieData;
-    QDataStream stream(&cookieData, QIODevice::WriteOnly);
-    stream << cookieFileVersion;
-    QList<QNetworkCookie> cookies = allCookies();
+QList<QNetworkCookie> CookieJar::cookiesForUrl(const QUrl& url) const
+{
+    QList<QNetworkCookie> result;
+    QString host = url.host();
+    QString domain = CookieStore::registrableDomain(host);
+    // loading the stored cookies is not a change of the jar
+    const_cast<CookieJar*>(this)->loadDomain(domain);
+    QHash<QString, QList<QNetworkCookie> >::const_iterator domainCookies = m_cookies.constFind(domain);
+    if (domainCookies == m_cookies.constEnd())
+        return result;
 
-    QMutableListIterator<QNetworkCookie> it(cookies);
-    while (it.hasNext()) {
-        if (it.next().isSessionCookie())
-            it.remove();
+    QDateTime now = QDateTime::currentDateTime();
+    bool isEncrypted = url.scheme().toLower() == QLatin1String("https");
+    QString path = url.path();
+    for (int i = 0; i < domainCookies->size(); ++i) {
+        const QNetworkCookie& cookie = domainCookies->at(i);
+        if (!isParentDomain(host, cookie.domain()) || !isParentPath(path, cookie.path()))
+            continue;
+        if (!cookie.isSessionCookie() && cookie.expirationDate() < now)
+            continue;
+        if (cookie.isSecure() && !isEncrypted)
+            continue;
+        // longer paths first
+        int j = 0;
+        while (j < result.size() && result.at(j).path().length() >= cookie.path().length())
+            ++j;
+        result.insert(j, cookie);
     }
+    return result;
+}
 
-    stream << qint32(cookies.count());
-    foreach (const QNetworkCookie& cookie, cookies)
-        stream << cookie.toRawForm();
-
-    QString cookieFileName = Settings::instance()->cookieFilePath();
-    QFile cookieFile(cookieFileName + ".tmp");
-    if (!cookieFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
-        return;
+bool CookieJar::setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url)
+{
+    bool added = false;
+    QString host = url.host();
+    foreach (const QNetworkCookie& cookie, cookieList) {
+        QNetworkCookie normalized = normalizedCookie(cookie, url);
+        QString domain = normalized.domain();
+        if (domain != host) {
+            // the rules of QNetworkCookieJar, with the public suffix check of CookieStore::registrableDomain()
+            if (!isParentDomain(domain, host) && !isParentDomain(host, domain))
+                continue;
+            if (!domain.mid(1).contains(QLatin1Char('.')) || CookieStore::registrableDomain(domain).isEmpty())
+                continue;
+        }
+        loadDomain(CookieStore::registrableDomain(domain));
+        if (insertCookie(normalized))
+            added = true;
+        m_store.cookieSet(normalized);
+    }
+    if (m_store.hasPendingRecords() && !m_cookieSavingTimer.isActive())
+        m_cookieSavingTimer.start(s_cookieSavingDelay, this);
+    return added;
+}
 
-    cookieFile.write(cookieData);
-    cookieFile.close();
-    // ### use atomic rename
-    QFile::remove(cookieFileName);
-    cookieFile.rename(cookieFileName);
-    m_cookiesChanged = false;
+/*!
+  Fills in the domain and path the way QNetworkCookieJar does.
+*/
+QNetworkCookie CookieJar::normalizedCookie(const QNetworkCookie& cookie, const QUrl& url) const
+{
+    QNetworkCookie normalized(cookie);
+    if (normalized.path().isEmpty()) {
+        QString defaultPath = url.path();
+        defaultPath.truncate(defaultPath.lastIndexOf(QLatin1Char('/')) + 1);
+        if (defaultPath.isEmpty())
+            defaultPath = QLatin1Char('/');
+        normalized.setPath(defaultPath);
+    }
+    if (normalized.domain().isEmpty())
+        normalized.setDomain(url.host());
+    else if (!normalized.domain().startsWith(QLatin1Char('.')))
+        normalized.setDomain(QLatin1Char('.') + normalized.domain());
+    return normalized;
 }
 
-void CookieJar::load()
+QList<QNetworkCookie> CookieJar::cookies() const
 {
-    QFile cookieFile(Settings::instance()->cookieFilePath());
-    if (!cookieFile.open(QIODevice::ReadOnly))
-        return;
+    QList<QNetworkCookie> all;
+    QHash<QString, QList<QNetworkCookie> >::const_iterator it = m_cookies.constBegin();
+    for (; it != m_cookies.constEnd(); ++it)
+        all += *it;
+    return all;
+}
 
-    QDataStream stream(&cookieFile);
-    quint8 version;
-    stream >> version;
-    if (version != cookieFileVersion)
-        return;
+/*!
+  Adds \a cookie, replacing the one with the same name, domain and path.
+  An expired cookie only removes the one it replaces. Returns true if
+  the cookie was added.
+*/
+bool CookieJar::insertCookie(const QNetworkCookie& cookie)
+{
+    QString domain = CookieStore::registrableDomain(cookie.domain());
+    QList<QNetworkCookie>& domainCookies = m_cookies[domain];
+    for (int i = 0; i < domainCookies.size(); ++i) {
+        if (isSameCookie(domainCookies.at(i), cookie)) {
+            removeCookie(domainCookies, i);
+            break;
+        }
+    }
 
-    QList<QNetworkCookie> cookies;
-    qint32 count;
-    stream >> count;
-
-#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
-    cookies.reserve(count);
-#endif
-    for (int i = 0; i < count && !stream.atEnd(); ++i) {
-        QByteArray rawCookie;
-        stream >> rawCookie;
-        cookies += QNetworkCookie::parseCookies(rawCookie);
+    QDateTime now = QDateTime::currentDateTime();
+    if (!cookie.isSessionCookie() && cookie.expirationDate() < now) {
+        if (domainCookies.isEmpty())
+            m_cookies.remove(domain);
+        return false;
     }
 
-    setAllCookies(cookies);
-    m_cookiesChanged = false;
+    domainCookies.append(cookie);
+    if (!cookie.isSessionCookie())
+        m_expiry.insert(cookie.expirationDate().toTime_t(), cookieKey(cookie));
+    return true;
+}
 
-    expireCookies();
+void CookieJar::removeCookie(QList<QNetworkCookie>& domainCookies, int i)
+{
+    const QNetworkCookie& cookie = domainCookies.at(i);
+    if (!cookie.isSessionCookie())
+        m_expiry.remove(cookie.expirationDate().toTime_t(), cookieKey(cookie));
+    domainCookies.removeAt(i);
 }
 
-bool CookieJar::setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url)
+/*!
+  Drops the expired cookies, only the ones that did expire are looked at.
+*/
+void CookieJar::expireCookies()
 {
-    m_cookiesChanged = true;
-    return QNetworkCookieJar::setCookiesFromUrl(cookieList, url);
+    uint now = QDateTime::currentDateTime().toTime_t();
+    while (!m_expiry.isEmpty() && m_expiry.begin().key() < now) {
+        QString key = m_expiry.begin().value();
+        // the domain goes up to the first ';', see cookieKey()
+        QString domain = CookieStore::registrableDomain(key.left(key.indexOf(QLatin1Char(';'))));
+        QList<QNetworkCookie>& domainCookies = m_cookies[domain];
+        int i = 0;
+        while (i < domainCookies.size() && cookieKey(domainCookies.at(i)) != key)
+            ++i;
+        if (i < domainCookies.size())
+            removeCookie(domainCookies, i);
+        else
+            m_expiry.erase(m_expiry.begin());
+        if (domainCookies.isEmpty())
+            m_cookies.remove(domain);
+    }
 }
 
 void CookieJar::timerEvent(QTimerEvent* ev)
@@ -120,21 +259,3 @@ void CookieJar::timerEvent(QTimerEvent* ev)
     }
     return QObject::timerEvent(ev);
 }
-
-void CookieJar::expireCookies()
-{
-    const QList<QNetworkCookie>& currentCookies = allCookies();
-    QList<QNetworkCookie> newCookies;
-#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
-    newCookies.reserve(currentCookies.count());
-#endif    
-    QDateTime now = QDateTime::currentDateTime();
-    foreach (const QNetworkCookie& cookie, currentCookies) {
-        if (!cookie.isSessionCookie() && cookie.expirationDate() < now) {
-            m_cookiesChanged = true;
-            continue;
-        }
-        newCookies += cookie;
-    }
-    setAllCookies(newCookies);
-}
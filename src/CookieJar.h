@@ -23,6 +23,9 @@
 
 #include <QNetworkCookieJar>
 #include <QBasicTimer>
+#include <QHash>
+#include <QMultiMap>
+#include "CookieStore.h"
 
 class CookieJar : public QNetworkCookieJar
 {
@@ -34,16 +37,26 @@ public:
     void save();
     void load();
 
+    virtual QList<QNetworkCookie> cookiesForUrl(const QUrl& url) const;
     virtual bool setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url);
 
 protected:
     virtual void timerEvent(QTimerEvent* ev);
 
 private:
+    void loadDomain(const QString& domain);
+    QNetworkCookie normalizedCookie(const QNetworkCookie& cookie, const QUrl& url) const;
+    QList<QNetworkCookie> cookies() const;
+    bool insertCookie(const QNetworkCookie& cookie);
+    void removeCookie(QList<QNetworkCookie>& domainCookies, int i);
     void expireCookies();
+
+    CookieStore m_store;
     QBasicTimer m_cookieSavingTimer;
-    bool m_cookiesChanged;
+    // registrable domain -> cookies, a url only looks at the cookies of its own site
+    QHash<QString, QList<QNetworkCookie> > m_cookies;
+    // expiration time -> cookie key, the next cookie to expire first
+    QMultiMap<uint, QString> m_expiry;
 };
 
 #endif
-
@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "CookieStore.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include <stdio.h>
+
+// version 1 was a flat list of cookies, version 2 had no index
+static const quint8 s_snapshotVersion = 3;
+static const quint8 s_logVersion = 2;
+// the log is folded into the snapshot once it has this many records, and more than the snapshot has cookies
+static const int s_minCompactionRecords = 256;
+
+static const QSet<QString> s_secondLevelSuffixes = QSet<QString>()
+    << "ac" << "co" << "com" << "edu" << "gov" << "ne" << "net" << "or" << "org";
+
+enum CookieRecordType {
+    SetRecord,
+    RemoveRecord
+};
+
+static QByteArray cookieKey(const QNetworkCookie& cookie)
+{
+    return cookie.domain().toUtf8() + ';' + cookie.path().toUtf8() + ';' + cookie.name();
+}
+
+static bool isPersistent(const QNetworkCookie& cookie, const QDateTime& now)
+{
+    return !cookie.isSessionCookie() && cookie.expirationDate() >= now;
+}
+
+// the records of an unfinished compaction go in front of the current ones
+static bool appendLog(const QString& fromFileName, const QString& toFileName)
+{
+    QFile from(fromFileName);
+    QFile to(toFileName);
+    if (!from.open(QIODevice::ReadOnly) || !to.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+    // both start with the version
+    from.seek(sizeof(s_logVersion));
+    return to.write(from.readAll()) != -1;
+}
+
+/*!
+  \class CookieStore keeps the persistent cookies on disk.
+
+  The snapshot file has the cookies grouped by registrable domain and an
+  index of the groups. Loading reads only the index and the log, the
+  cookies of a domain are parsed when the jar first needs them, see
+  loadDomain().
+
+  The changes since the snapshot was written go to a log next to it.
+  Once the log grows long it is folded into a new snapshot in a worker
+  thread, the new snapshot replaces the old one with an atomic rename.
+  Changes are written to the log in batches, see flush().
+*/
+CookieStore::CookieStore(const QString& fileName)
+    : m_fileName(fileName)
+    , m_legacySnapshot(false)
+    , m_pendingRecords(0)
+    , m_logRecords(0)
+    , m_snapshotCookies(0)
+    , m_compactionFinished(true)
+{
+}
+
+CookieStore::~CookieStore()
+{
+    flush();
+    waitForCompaction();
+}
+
+/*!
+  Reads the snapshot index and the logs, no cookie is parsed yet.
+*/
+void CookieStore::load()
+{
+    waitForCompaction();
+    m_unloaded.clear();
+    m_snapshotCookies = 0;
+    readIndex();
+    // an old log is left behind by a compaction that did not finish
+    m_logRecords = readLog(oldLogFileName());
+    m_logRecords += readLog(logFileName());
+}
+
+void CookieStore::readIndex()
+{
+    m_snapshot.close();
+    m_snapshot.setFileName(m_fileName);
+    if (!m_snapshot.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&m_snapshot);
+    quint8 version;
+    stream >> version;
+    if (version != s_snapshotVersion) {
+        readLegacySnapshot(stream, version);
+        m_snapshot.close();
+        return;
+    }
+
+    qint64 indexOffset;
+    stream >> indexOffset;
+    m_snapshot.seek(indexOffset);
+    qint32 domainCount;
+    stream >> domainCount;
+    for (int i = 0; i < domainCount && stream.status() == QDataStream::Ok; ++i) {
+        QString domain;
+        DomainEntry entry;
+        stream >> domain >> entry.offset >> entry.count;
+        m_unloaded.insert(domain, entry);
+        m_snapshotCookies += entry.count;
+    }
+}
+
+void CookieStore::readLegacySnapshot(QDataStream& stream, quint8 version)
+{
+    if (version != 1 && version != 2)
+        return;
+    m_legacySnapshot = true;
+
+    // version 1 is read as a single group
+    qint32 groupCount = 1;
+    if (version == 2)
+        stream >> groupCount;
+    for (int i = 0; i < groupCount && !stream.atEnd(); ++i) {
+        QString groupDomain;
+        if (version == 2)
+            stream >> groupDomain;
+        qint32 count;
+        stream >> count;
+        for (int j = 0; j < count && !stream.atEnd(); ++j) {
+            QByteArray rawCookie;
+            stream >> rawCookie;
+            QString domain = groupDomain;
+            // one time conversion, the flat list needs parsing to find the domains
+            if (version == 1) {
+                QList<QNetworkCookie> parsed = QNetworkCookie::parseCookies(rawCookie);
+                if (parsed.isEmpty())
+                    continue;
+                domain = parsed.first().domain();
+            }
+            m_unloaded[registrableDomain(domain)].rawCookies.append(rawCookie);
+            m_snapshotCookies++;
+        }
+    }
+}
+
+int CookieStore::readLog(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    QDataStream stream(&file);
+    quint8 version;
+    stream >> version;
+    if (version != s_logVersion)
+        return 0;
+
+    int records = 0;
+    while (!stream.atEnd()) {
+        QString domain;
+        LogRecord record;
+        stream >> record.type >> domain >> record.rawCookie;
+        // a record cut short by a crash ends the log
+        if (stream.status() != QDataStream::Ok)
+            break;
+        m_unloaded[domain].log.append(record);
+        records++;
+    }
+    return records;
+}
+
+void CookieStore::readDomain(QFile& snapshot, DomainEntry& entry)
+{
+    if (entry.offset < 0)
+        return;
+    if (snapshot.seek(entry.offset)) {
+        QDataStream stream(&snapshot);
+        for (int i = 0; i < entry.count && stream.status() == QDataStream::Ok; ++i) {
+            QByteArray rawCookie;
+            stream >> rawCookie;
+            entry.rawCookies.append(rawCookie);
+        }
+    }
+    entry.offset = -1;
+}
+
+/*!
+  Returns the stored cookies of the registrable \a domain, expired ones
+  left out. The cookies are handed out once, the jar keeps them after.
+*/
+QList<QNetworkCookie> CookieStore::loadDomain(const QString& domain)
+{
+    finishCompaction();
+    if (!m_unloaded.contains(domain))
+        return QList<QNetworkCookie>();
+    DomainEntry entry = m_unloaded.take(domain);
+    readDomain(m_snapshot, entry);
+    return parseDomain(entry);
+}
+
+QList<QNetworkCookie> CookieStore::parseDomain(const DomainEntry& entry)
+{
+    QHash<QByteArray, QNetworkCookie> cookies;
+    for (int i = 0; i < entry.rawCookies.size(); ++i) {
+        QList<QNetworkCookie> parsed = QNetworkCookie::parseCookies(entry.rawCookies.at(i));
+        for (int j = 0; j < parsed.size(); ++j)
+            cookies.insert(cookieKey(parsed.at(j)), parsed.at(j));
+    }
+    for (int i = 0; i < entry.log.size(); ++i) {
+        QList<QNetworkCookie> parsed = QNetworkCookie::parseCookies(entry.log.at(i).rawCookie);
+        for (int j = 0; j < parsed.size(); ++j) {
+            if (entry.log.at(i).type == SetRecord)
+                cookies.insert(cookieKey(parsed.at(j)), parsed.at(j));
+            else
+                cookies.remove(cookieKey(parsed.at(j)));
+        }
+    }
+
+    QList<QNetworkCookie> persistent;
+    QDateTime now = QDateTime::currentDateTime();
+    QHash<QByteArray, QNetworkCookie>::const_iterator it = cookies.constBegin();
+    for (; it != cookies.constEnd(); ++it) {
+        if (isPersistent(*it, now))
+            persistent.append(*it);
+    }
+    return persistent;
+}
+
+/*!
+  Records \a cookie as set in the jar. Session cookies are not stored,
+  but they do replace a stored cookie of the same name.
+*/
+void CookieStore::cookieSet(const QNetworkCookie& cookie)
+{
+    appendRecord(isPersistent(cookie, QDateTime::currentDateTime()) ? SetRecord : RemoveRecord, cookie);
+}
+
+void CookieStore::cookieRemoved(const QNetworkCookie& cookie)
+{
+    appendRecord(RemoveRecord, cookie);
+}
+
+void CookieStore::appendRecord(quint8 type, const QNetworkCookie& cookie)
+{
+    QDataStream stream(&m_pending, QIODevice::WriteOnly | QIODevice::Append);
+    stream << type << registrableDomain(cookie.domain()) << cookie.toRawForm();
+    m_pendingRecords++;
+}
+
+/*!
+  Appends the pending records to the log.
+*/
+void CookieStore::flush()
+{
+    if (!m_pendingRecords)
+        return;
+
+    QFile log(logFileName());
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append))
+        return;
+    if (!log.size()) {
+        QDataStream stream(&log);
+        stream << s_logVersion;
+    }
+    if (log.write(m_pending) != m_pending.size())
+        return;
+    m_logRecords += m_pendingRecords;
+    m_pending.clear();
+    m_pendingRecords = 0;
+}
+
+bool CookieStore::compactionNeeded() const
+{
+    if (m_compaction.isRunning())
+        return false;
+    return m_legacySnapshot || (m_logRecords >= s_minCompactionRecords && m_logRecords > m_snapshotCookies);
+}
+
+/*!
+  Writes \a cookies, the cookies the jar has loaded, and the ones not
+  loaded yet as the new snapshot. The reading, parsing and writing happen
+  in a worker thread, changes logged meanwhile go to a new log.
+*/
+void CookieStore::compact(const QList<QNetworkCookie>& cookies)
+{
+    if (m_compaction.isRunning())
+        return;
+    finishCompaction();
+    flush();
+
+    if (QFile::exists(oldLogFileName())) {
+        if (QFile::exists(logFileName()) && !appendLog(logFileName(), oldLogFileName()))
+            return;
+        QFile::remove(logFileName());
+    } else if (QFile::exists(logFileName()) && !QFile::rename(logFileName(), oldLogFileName()))
+        return;
+
+    m_legacySnapshot = false;
+    m_logRecords = 0;
+    m_snapshotCookies = cookies.size();
+    // the cookies and the entries are implicitly shared, the worker reads its own
+    // copies. the entries are at their offsets in the file m_snapshot has open,
+    // it is still there under m_fileName as finishCompaction() reopened it
+    m_compaction = QtConcurrent::run(writeSnapshot, m_fileName, oldLogFileName(), cookies, m_unloaded);
+    m_compactionFinished = false;
+}
+
+void CookieStore::waitForCompaction()
+{
+    m_compaction.waitForFinished();
+    finishCompaction();
+}
+
+/*!
+  Once a compaction has replaced the snapshot, the domains still not
+  loaded are read from the new one.
+*/
+void CookieStore::finishCompaction()
+{
+    if (m_compactionFinished || !m_compaction.isFinished())
+        return;
+    m_compactionFinished = true;
+    Snapshot snapshot = m_compaction.result();
+    if (!snapshot.written)
+        return;
+
+    m_snapshot.close();
+    m_snapshot.setFileName(m_fileName);
+    m_snapshot.open(QIODevice::ReadOnly);
+    QHash<QString, DomainEntry>::iterator it = m_unloaded.begin();
+    for (; it != m_unloaded.end(); ++it) {
+        DomainEntry written = snapshot.domains.value(it.key());
+        it->offset = written.offset;
+        it->count = written.count;
+        it->rawCookies.clear();
+        // only the logs read on load() have records of unloaded domains, they are in the snapshot now
+        it->log.clear();
+    }
+}
+
+CookieStore::Snapshot CookieStore::writeSnapshot(const QString& fileName, const QString& oldLogFileName, QList<QNetworkCookie> cookies, QHash<QString, DomainEntry> unloaded)
+{
+    Snapshot snapshot;
+    QFile oldSnapshot(fileName);
+    oldSnapshot.open(QIODevice::ReadOnly);
+    QHash<QString, DomainEntry>::iterator entry = unloaded.begin();
+    for (; entry != unloaded.end(); ++entry) {
+        readDomain(oldSnapshot, *entry);
+        cookies += parseDomain(*entry);
+    }
+    oldSnapshot.close();
+
+    QMap<QString, QList<QNetworkCookie> > domains;
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < cookies.size(); ++i) {
+        if (isPersistent(cookies.at(i), now))
+            domains[registrableDomain(cookies.at(i).domain())].append(cookies.at(i));
+    }
+
+    QString tmpFileName = fileName + ".tmp";
+    QFile file(tmpFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return snapshot;
+    QDataStream stream(&file);
+    // the index goes last, its offset is filled in once known
+    stream << s_snapshotVersion << qint64(0);
+    QList<qint64> offsets;
+    QMap<QString, QList<QNetworkCookie> >::const_iterator it = domains.constBegin();
+    for (; it != domains.constEnd(); ++it) {
+        offsets.append(file.pos());
+        for (int i = 0; i < it->size(); ++i)
+            stream << it->at(i).toRawForm();
+    }
+    qint64 indexOffset = file.pos();
+    stream << qint32(domains.size());
+    int i = 0;
+    for (it = domains.constBegin(); it != domains.constEnd(); ++it, ++i) {
+        stream << it.key() << offsets.at(i) << qint32(it->size());
+        snapshot.domains[it.key()].offset = offsets.at(i);
+        snapshot.domains[it.key()].count = it->size();
+    }
+    file.seek(sizeof(s_snapshotVersion));
+    stream << indexOffset;
+    file.close();
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+        QFile::remove(tmpFileName);
+        return snapshot;
+    }
+
+    // unlike QFile::rename, replaces the old snapshot atomically
+    if (::rename(QFile::encodeName(tmpFileName).constData(), QFile::encodeName(fileName).constData())) {
+        qWarning() << "CookieStore: failed to replace" << fileName;
+        QFile::remove(tmpFileName);
+        return snapshot;
+    }
+    // the old log is in the snapshot now
+    QFile::remove(oldLogFileName);
+    snapshot.written = true;
+    return snapshot;
+}
+
+/*!
+  Returns the registrable part of \a domain, example.com for
+  www.example.com and example.co.uk for www.example.co.uk, or an empty
+  string if \a domain is a public suffix itself.
+
+  FIXME: there is no public suffix list, only the common second level
+  labels of country domains (co.uk, com.au) are known suffixes.
+*/
+QString CookieStore::registrableDomain(const QString& domain)
+{
+    QString host = (domain.startsWith(QLatin1Char('.')) ? domain.mid(1) : domain).toLower();
+    // ip addresses and single label hosts, like localhost, are their own site
+    if (!host.contains(QLatin1Char('.')) || host.at(host.length() - 1).isDigit())
+        return host;
+    QStringList labels = host.split(QLatin1Char('.'), QString::SkipEmptyParts);
+    int suffixLabels = 1;
+    if (labels.last().length() == 2 && labels.size() >= 2 && s_secondLevelSuffixes.contains(labels.at(labels.size() - 2)))
+        suffixLabels = 2;
+    if (labels.size() <= suffixLabels)
+        return QString();
+    return QStringList(labels.mid(labels.size() - suffixLabels - 1)).join(QLatin1String("."));
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CookieStore_h_
+#define CookieStore_h_
+
+#include <QByteArray>
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QNetworkCookie>
+#include <QString>
+
+class CookieStore {
+public:
+    explicit CookieStore(const QString& fileName);
+    ~CookieStore();
+
+    void load();
+    bool isLoaded(const QString& domain) const { return !m_unloaded.contains(domain); }
+    QList<QNetworkCookie> loadDomain(const QString& domain);
+
+    void cookieSet(const QNetworkCookie& cookie);
+    void cookieRemoved(const QNetworkCookie& cookie);
+    bool hasPendingRecords() const { return m_pendingRecords > 0; }
+    void flush();
+
+    bool compactionNeeded() const;
+    void compact(const QList<QNetworkCookie>& cookies);
+    void waitForCompaction();
+
+    static QString registrableDomain(const QString& domain);
+
+private:
+    struct LogRecord {
+        quint8 type;
+        QByteArray rawCookie;
+    };
+
+    // the stored cookies of a registrable domain, until the jar asks for them
+    struct DomainEntry {
+        DomainEntry() : offset(-1), count(0) {}
+        // of the raw cookies in the snapshot, -1 once they are read
+        qint64 offset;
+        qint32 count;
+        QList<QByteArray> rawCookies;
+        // changes logged after the snapshot was written
+        QList<LogRecord> log;
+    };
+
+    // what a compaction wrote, the index of the new snapshot
+    struct Snapshot {
+        Snapshot() : written(false) {}
+        bool written;
+        QHash<QString, DomainEntry> domains;
+    };
+
+    void readIndex();
+    void readLegacySnapshot(QDataStream& stream, quint8 version);
+    int readLog(const QString& fileName);
+    static void readDomain(QFile& snapshot, DomainEntry& entry);
+    void appendRecord(quint8 type, const QNetworkCookie& cookie);
+    QString logFileName() const { return m_fileName + ".log"; }
+    QString oldLogFileName() const { return m_fileName + ".log.old"; }
+
+    static QList<QNetworkCookie> parseDomain(const DomainEntry& entry);
+    static Snapshot writeSnapshot(const QString& fileName, const QString& oldLogFileName, QList<QNetworkCookie> cookies, QHash<QString, DomainEntry> unloaded);
+    void finishCompaction();
+
+    QString m_fileName;
+    // kept open for the domains not loaded yet, reopened once a compaction has replaced the file
+    QFile m_snapshot;
+    QHash<QString, DomainEntry> m_unloaded;
+    // snapshots of the older versions have no index, they are rewritten
+    bool m_legacySnapshot;
+    QByteArray m_pending;
+    int m_pendingRecords;
+    // records in the log since the last compaction
+    int m_logRecords;
+    int m_snapshotCookies;
+    QFuture<Snapshot> m_compaction;
+    bool m_compactionFinished;
+};
+
+#endif
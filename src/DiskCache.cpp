@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "DiskCache.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QStringList>
+#include <QDebug>
+
+static const quint8 s_itemVersion = 1;
+static const quint8 s_indexVersion = 1;
+static const int s_saveIndexDelay = 10000;
+
+// collects a downloaded item, gives up on the ones bigger than maximumSize
+class ItemBuffer : public QBuffer {
+public:
+    explicit ItemBuffer(qint64 maximumSize)
+        : m_maximumSize(maximumSize)
+        , m_tooBig(false)
+    {
+    }
+
+    bool isTooBig() const { return m_tooBig; }
+
+protected:
+    qint64 writeData(const char* data, qint64 len)
+    {
+        if (m_tooBig)
+            return len;
+        if (size() + len > m_maximumSize) {
+            // the rest is thrown away as it comes
+            m_tooBig = true;
+            buffer().clear();
+            return len;
+        }
+        return QBuffer::writeData(data, len);
+    }
+
+private:
+    qint64 m_maximumSize;
+    bool m_tooBig;
+};
+
+/*!
+  \class DiskCache is the http cache shared by the web pages.
+
+  Every item is a file of its own, named after the hash of the url. An
+  index file keeps the sizes and the use order of the items, so the
+  least recently used ones are evicted without stating every file. The
+  index is saved on quit, the items written after that are picked up from
+  the directory on the next start.
+*/
+DiskCache::DiskCache(const QString& cacheDirectory, qint64 maximumCacheSize, QObject* parent)
+    : QAbstractNetworkCache(parent)
+    , m_cacheDirectory(cacheDirectory)
+    , m_maximumCacheSize(maximumCacheSize)
+    , m_cacheSize(0)
+    , m_serial(0)
+{
+    QDir().mkpath(m_cacheDirectory);
+    m_saveIndexTimer.setSingleShot(true);
+    m_saveIndexTimer.setInterval(s_saveIndexDelay);
+    connect(&m_saveIndexTimer, SIGNAL(timeout()), this, SLOT(saveIndex()));
+    // the cache goes with the application singletons, never deleted
+    connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(saveIndex()));
+    loadIndex();
+}
+
+DiskCache::~DiskCache()
+{
+    qDeleteAll(m_inserting.keys());
+    if (m_saveIndexTimer.isActive())
+        saveIndex();
+}
+
+QByteArray DiskCache::key(const QUrl& url)
+{
+    return QCryptographicHash::hash(url.toEncoded(QUrl::RemoveFragment), QCryptographicHash::Sha1).toHex();
+}
+
+QString DiskCache::fileName(const QByteArray& key) const
+{
+    return m_cacheDirectory + QString::fromLatin1(key) + ".cache";
+}
+
+QNetworkCacheMetaData DiskCache::metaData(const QUrl& url)
+{
+    QNetworkCacheMetaData metaData;
+    QByteArray itemKey = key(url);
+    if (m_entries.contains(itemKey) && !readItem(itemKey, metaData, 0))
+        removeEntry(itemKey);
+    return metaData;
+}
+
+void DiskCache::updateMetaData(const QNetworkCacheMetaData& metaData)
+{
+    QByteArray itemKey = key(metaData.url());
+    if (!m_entries.contains(itemKey))
+        return;
+    QNetworkCacheMetaData oldMetaData;
+    QByteArray data;
+    if (!readItem(itemKey, oldMetaData, &data) || !writeItem(itemKey, metaData, data))
+        removeEntry(itemKey);
+}
+
+QIODevice* DiskCache::data(const QUrl& url)
+{
+    QByteArray itemKey = key(url);
+    if (!m_entries.contains(itemKey))
+        return 0;
+    QNetworkCacheMetaData metaData;
+    QBuffer* buffer = new QBuffer;
+    if (!readItem(itemKey, metaData, &buffer->buffer())) {
+        delete buffer;
+        removeEntry(itemKey);
+        return 0;
+    }
+    buffer->open(QIODevice::ReadOnly);
+    touch(itemKey);
+    return buffer;
+}
+
+bool DiskCache::remove(const QUrl& url)
+{
+    // a download of the url may be in progress
+    QHash<QIODevice*, QNetworkCacheMetaData>::iterator it = m_inserting.begin();
+    while (it != m_inserting.end()) {
+        if (it->url() == url) {
+            delete it.key();
+            it = m_inserting.erase(it);
+        } else
+            ++it;
+    }
+
+    QByteArray itemKey = key(url);
+    if (!m_entries.contains(itemKey))
+        return false;
+    removeEntry(itemKey);
+    return true;
+}
+
+QIODevice* DiskCache::prepare(const QNetworkCacheMetaData& metaData)
+{
+    if (!metaData.isValid() || !metaData.url().isValid() || !metaData.saveToDisk())
+        return 0;
+    // too big to be worth evicting everything else for
+    ItemBuffer* buffer = new ItemBuffer(m_maximumCacheSize / 4);
+    buffer->open(QIODevice::ReadWrite);
+    m_inserting.insert(buffer, metaData);
+    return buffer;
+}
+
+void DiskCache::insert(QIODevice* device)
+{
+    if (!m_inserting.contains(device))
+        return;
+    QNetworkCacheMetaData metaData = m_inserting.take(device);
+    QByteArray itemKey = key(metaData.url());
+    ItemBuffer* buffer = static_cast<ItemBuffer*>(device);
+    if (buffer->isTooBig() || !writeItem(itemKey, metaData, buffer->data()))
+        removeEntry(itemKey);
+    delete device;
+    evict();
+}
+
+void DiskCache::clear()
+{
+    qDeleteAll(m_inserting.keys());
+    m_inserting.clear();
+    while (!m_entries.isEmpty())
+        removeEntry(m_entries.begin().key());
+    saveIndex();
+}
+
+bool DiskCache::readItem(const QByteArray& key, QNetworkCacheMetaData& metaData, QByteArray* data)
+{
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    quint8 version;
+    stream >> version;
+    if (version != s_itemVersion)
+        return false;
+    stream >> metaData;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+    if (data)
+        *data = file.readAll();
+    return true;
+}
+
+bool DiskCache::writeItem(const QByteArray& key, const QNetworkCacheMetaData& metaData, const QByteArray& data)
+{
+    QString itemFileName = fileName(key);
+    QFile file(itemFileName + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    QDataStream stream(&file);
+    stream << s_itemVersion << metaData;
+    bool ok = stream.status() == QDataStream::Ok && file.write(data) == data.size();
+    qint64 size = file.size();
+    file.close();
+    QFile::remove(itemFileName);
+    if (!ok || !file.rename(itemFileName)) {
+        file.remove();
+        return false;
+    }
+
+    Entry& entry = m_entries[key];
+    m_cacheSize += size - entry.size;
+    entry.size = size;
+    touch(key);
+    return true;
+}
+
+void DiskCache::touch(const QByteArray& key)
+{
+    Entry& entry = m_entries[key];
+    m_lru.remove(entry.serial);
+    entry.serial = ++m_serial;
+    m_lru.insert(entry.serial, key);
+    saveIndexSoon();
+}
+
+void DiskCache::removeEntry(const QByteArray& key)
+{
+    QFile::remove(fileName(key));
+    QHash<QByteArray, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+    m_cacheSize -= it->size;
+    m_lru.remove(it->serial);
+    m_entries.erase(it);
+    saveIndexSoon();
+}
+
+void DiskCache::evict()
+{
+    while (m_cacheSize > m_maximumCacheSize && !m_lru.isEmpty())
+        removeEntry(m_lru.begin().value());
+}
+
+void DiskCache::loadIndex()
+{
+    QFile file(m_cacheDirectory + "index");
+    if (!file.open(QIODevice::ReadOnly)) {
+        rebuildIndex();
+        return;
+    }
+    QDataStream stream(&file);
+    quint8 version;
+    qint32 count;
+    stream >> version >> m_serial >> count;
+    if (version != s_indexVersion) {
+        rebuildIndex();
+        return;
+    }
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        Entry entry;
+        stream >> key >> entry.size >> entry.serial;
+        m_entries.insert(key, entry);
+        m_lru.insert(entry.serial, key);
+        m_cacheSize += entry.size;
+    }
+    reconcileIndex();
+    // the budget may have changed
+    evict();
+}
+
+/*!
+  Brings the loaded index up to date with the cache directory, the index
+  on disk misses the changes made after it was last saved.
+*/
+void DiskCache::reconcileIndex()
+{
+    QDir dir(m_cacheDirectory);
+    QStringList files = dir.entryList(QStringList() << "*.cache" << "*.tmp", QDir::Files);
+    QSet<QByteArray> found;
+    for (int i = 0; i < files.size(); ++i) {
+        const QString& file = files.at(i);
+        // left behind by a write that did not finish
+        if (file.endsWith(".tmp")) {
+            dir.remove(file);
+            continue;
+        }
+        QByteArray key = QFileInfo(file).completeBaseName().toLatin1();
+        found.insert(key);
+        if (m_entries.contains(key))
+            continue;
+        Entry& entry = m_entries[key];
+        entry.size = QFileInfo(dir, file).size();
+        m_cacheSize += entry.size;
+        touch(key);
+    }
+
+    QList<QByteArray> keys = m_entries.keys();
+    for (int i = 0; i < keys.size(); ++i) {
+        if (!found.contains(keys.at(i)))
+            removeEntry(keys.at(i));
+    }
+}
+
+/*!
+  Indexes the items found in the cache directory, oldest first. Only
+  needed when the index is lost.
+*/
+void DiskCache::rebuildIndex()
+{
+    QDir dir(m_cacheDirectory);
+    QFileInfoList files = dir.entryInfoList(QStringList("*.cache"), QDir::Files, QDir::Time | QDir::Reversed);
+    for (int i = 0; i < files.size(); ++i) {
+        QByteArray key = files.at(i).completeBaseName().toLatin1();
+        Entry& entry = m_entries[key];
+        entry.size = files.at(i).size();
+        m_cacheSize += entry.size;
+        touch(key);
+    }
+    evict();
+}
+
+void DiskCache::saveIndexSoon()
+{
+    if (!m_saveIndexTimer.isActive())
+        m_saveIndexTimer.start();
+}
+
+void DiskCache::saveIndex()
+{
+    m_saveIndexTimer.stop();
+    QString indexFileName = m_cacheDirectory + "index";
+    QFile file(indexFileName + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    QDataStream stream(&file);
+    stream << s_indexVersion << m_serial << qint32(m_entries.size());
+    QHash<QByteArray, Entry>::const_iterator it = m_entries.constBegin();
+    for (; it != m_entries.constEnd(); ++it)
+        stream << it.key() << it->size << it->serial;
+    file.close();
+    if (stream.status() != QDataStream::Ok) {
+        file.remove();
+        return;
+    }
+    QFile::remove(indexFileName);
+    file.rename(indexFileName);
+}
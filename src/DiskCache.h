@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef DiskCache_h_
+#define DiskCache_h_
+
+#include <QAbstractNetworkCache>
+#include <QHash>
+#include <QMap>
+#include <QTimer>
+
+class DiskCache : public QAbstractNetworkCache {
+    Q_OBJECT
+public:
+    DiskCache(const QString& cacheDirectory, qint64 maximumCacheSize, QObject* parent = 0);
+    ~DiskCache();
+
+    QNetworkCacheMetaData metaData(const QUrl& url);
+    void updateMetaData(const QNetworkCacheMetaData& metaData);
+    QIODevice* data(const QUrl& url);
+    bool remove(const QUrl& url);
+    qint64 cacheSize() const { return m_cacheSize; }
+    QIODevice* prepare(const QNetworkCacheMetaData& metaData);
+    void insert(QIODevice* device);
+
+public Q_SLOTS:
+    void clear();
+
+private Q_SLOTS:
+    void saveIndex();
+
+private:
+    struct Entry {
+        Entry() : size(0), serial(0) {}
+        qint64 size;
+        // larger is more recently used
+        quint64 serial;
+    };
+
+    static QByteArray key(const QUrl& url);
+    QString fileName(const QByteArray& key) const;
+    bool readItem(const QByteArray& key, QNetworkCacheMetaData& metaData, QByteArray* data);
+    bool writeItem(const QByteArray& key, const QNetworkCacheMetaData& metaData, const QByteArray& data);
+    void touch(const QByteArray& key);
+    void removeEntry(const QByteArray& key);
+    void evict();
+    void loadIndex();
+    void reconcileIndex();
+    void rebuildIndex();
+    void saveIndexSoon();
+
+    QString m_cacheDirectory;
+    qint64 m_maximumCacheSize;
+    qint64 m_cacheSize;
+    quint64 m_serial;
+    QHash<QByteArray, Entry> m_entries;
+    // serial -> key, the least recently used first
+    QMap<quint64, QByteArray> m_lru;
+    // devices handed out by prepare(), not inserted yet
+    QHash<QIODevice*, QNetworkCacheMetaData> m_inserting;
+    QTimer m_saveIndexTimer;
+};
+
+#endif
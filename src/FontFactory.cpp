@@ -21,11 +21,15 @@
 #include "FontFactory.h"
 
 #include <QFontDatabase>
+#include <QPainter>
+#include <QRectF>
 #include <QStringList>
 #include <QRegExp>
 #include <QDebug>
 
 const QString s_defaultFontFamily = QString("Nokia Sans");
+// a few screenfuls of tiles, each with a title and an url
+const int s_maxCachedTexts = 500;
 
 // FIXME this needs some proper API. barebone, all we need, impl atm.
 FontFactory* FontFactory::instance()
@@ -37,6 +41,9 @@ FontFactory* FontFactory::instance()
 }
 
 FontFactory::FontFactory()
+    : m_smallMetrics(m_smallFont)
+    , m_mediumMetrics(m_mediumFont)
+    , m_bigMetrics(m_bigFont)
 {
     QString fontFamily = s_defaultFontFamily;
     // Find something Sans'ish; if not, pick the first one.
@@ -70,4 +77,73 @@ FontFactory::FontFactory()
     m_smallFont.setPointSize(small);
     m_mediumFont.setPointSize(medium);
     m_bigFont.setPointSize(big);
+
+    m_smallMetrics = QFontMetrics(m_smallFont);
+    m_mediumMetrics = QFontMetrics(m_mediumFont);
+    m_bigMetrics = QFontMetrics(m_bigFont);
+
+    m_elidedTexts.setMaxCost(s_maxCachedTexts);
+#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+    m_staticTexts.setMaxCost(s_maxCachedTexts);
+#endif
+}
+
+QFontMetrics FontFactory::metrics(const QFont& font) const
+{
+    if (font == m_smallFont)
+        return m_smallMetrics;
+    if (font == m_mediumFont)
+        return m_mediumMetrics;
+    if (font == m_bigFont)
+        return m_bigMetrics;
+    // not one of ours, nothing to share
+    return QFontMetrics(font);
+}
+
+/*!
+  Same as QFontMetrics::elidedText() for one of the factory fonts, but
+  remembers the result. Tiles elide the same titles with the same widths
+  over and over on relayouts.
+*/
+QString FontFactory::elidedText(const QFont& font, const QString& text, Qt::TextElideMode mode, int width)
+{
+    QString key = font.key() + QLatin1Char('\n') + QString::number(mode) + QLatin1Char('\n') + QString::number(width) + QLatin1Char('\n') + text;
+    if (QString* cached = m_elidedTexts.object(key))
+        return *cached;
+    QString elided = metrics(font).elidedText(text, mode, width);
+    m_elidedTexts.insert(key, new QString(elided));
+    return elided;
+}
+
+/*!
+  Draws single line \a text aligned in \a rect. With Qt 4.7 the text is
+  laid out once and kept as a QStaticText.
+*/
+void FontFactory::drawText(QPainter* painter, const QFont& font, const QRectF& rect, int alignment, const QString& text)
+{
+    painter->setFont(font);
+#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+    QString key = font.key() + QLatin1Char('\n') + text;
+    QStaticText* staticText = m_staticTexts.object(key);
+    if (!staticText) {
+        staticText = new QStaticText(text);
+        staticText->setTextFormat(Qt::PlainText);
+        staticText->prepare(QTransform(), font);
+        m_staticTexts.insert(key, staticText);
+    }
+
+    QSizeF size = staticText->size();
+    QPointF pos = rect.topLeft();
+    if (alignment & Qt::AlignHCenter)
+        pos.rx() += (rect.width() - size.width()) / 2;
+    else if (alignment & Qt::AlignRight)
+        pos.rx() += rect.width() - size.width();
+    if (alignment & Qt::AlignVCenter)
+        pos.ry() += (rect.height() - size.height()) / 2;
+    else if (alignment & Qt::AlignBottom)
+        pos.ry() += rect.height() - size.height();
+    painter->drawStaticText(pos, *staticText);
+#else
+    painter->drawText(rect, alignment, text);
+#endif
 }
@@ -21,7 +21,16 @@
 #ifndef FontFactory_h_
 #define FontFactory_h_
 
+#include <QCache>
 #include <QFont>
+#include <QFontMetrics>
+#include <QString>
+#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+#include <QStaticText>
+#endif
+
+class QPainter;
+class QRectF;
 
 class FontFactory {
 public:
@@ -30,13 +39,32 @@ public:
     const QFont& small() { return m_smallFont; }
     const QFont& medium() { return m_mediumFont; }
     const QFont& big() { return m_bigFont; }
+
+    const QFontMetrics& smallMetrics() { return m_smallMetrics; }
+    const QFontMetrics& mediumMetrics() { return m_mediumMetrics; }
+    const QFontMetrics& bigMetrics() { return m_bigMetrics; }
+
+    QString elidedText(const QFont& font, const QString& text, Qt::TextElideMode mode, int width);
+    void drawText(QPainter* painter, const QFont& font, const QRectF& rect, int alignment, const QString& text);
     
 private:
     FontFactory();
 
+    QFontMetrics metrics(const QFont& font) const;
+
     QFont m_smallFont;
     QFont m_mediumFont;
     QFont m_bigFont;
+    QFontMetrics m_smallMetrics;
+    QFontMetrics m_mediumMetrics;
+    QFontMetrics m_bigMetrics;
+
+    // font key, elide mode, width and text -> elided text
+    QCache<QString, QString> m_elidedTexts;
+#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+    // font key and text -> laid out text
+    QCache<QString, QStaticText> m_staticTexts;
+#endif
 };
 
 #endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "FpsOverlayWidget.h"
+#include "FontFactory.h"
+#include "WebView.h"
+
+#include <QPainter>
+#include <QFontMetrics>
+
+static const int s_updateTimeout = 500;
+// frames older than this fall out of the histogram
+static const qint64 s_statsWindow = 2000000;
+static const QColor s_bckgColor(20, 20, 20, 200);
+static const QColor s_textColor(10, 255, 10);
+static const QColor s_slowFrameColor(255, 10, 10);
+// frames slower than 60fps get painted red
+static const int s_fastBucketCount = 3;
+
+/*!
+  \class FpsOverlayWidget shows the frame rate and the frame time
+  histogram of the active web view (-f)
+*/
+FpsOverlayWidget::FpsOverlayWidget(QGraphicsItem* parent)
+    : QGraphicsWidget(parent)
+    , m_webView(0)
+    , m_frameCount(0)
+    , m_fps(0)
+    , m_longestFrame(0)
+{
+    setAcceptedMouseButtons(Qt::NoButton);
+    m_buckets.fill(0, FrameStats::bucketCount());
+    connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateStats()));
+    m_updateTimer.start(s_updateTimeout);
+}
+
+void FpsOverlayWidget::setWebView(WebView* webView)
+{
+    if (m_webView)
+        m_webView->setFrameStatsExcludedRect(QRectF());
+    m_webView = webView;
+    m_frames.clear();
+    m_frameCount = m_webView ? m_webView->frameStats().frameCount() : 0;
+    updateStats();
+}
+
+void FpsOverlayWidget::updateStats()
+{
+    if (!m_webView)
+        return;
+
+    m_frameCount = m_webView->frameStats().frames(m_frameCount, m_frames);
+
+    qint64 now = FrameStats::now();
+    int old = 0;
+    while (old < m_frames.size() && now - m_frames.at(old).timestamp > s_statsWindow)
+        ++old;
+    m_frames.remove(0, old);
+
+    m_longestFrame = 0;
+    int lastSecond = 0;
+    for (int i = 0; i < m_frames.size(); ++i) {
+        m_longestFrame = qMax(m_longestFrame, m_frames.at(i).duration / 1000.);
+        if (now - m_frames.at(i).timestamp <= 1000000)
+            ++lastSecond;
+    }
+    m_fps = lastSecond;
+    FrameStats::histogram(m_frames, m_buckets);
+    // the overlay is translucent, repainting it repaints the view below
+    m_webView->setFrameStatsExcludedRect(mapRectToScene(rect()));
+    update();
+}
+
+void FpsOverlayWidget::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
+{
+    QRectF r(rect());
+    painter->fillRect(r, s_bckgColor);
+
+    const QFont& f = FontFactory::instance()->small();
+    int textHeight = QFontMetrics(f).height();
+    painter->setFont(f);
+    painter->setPen(s_textColor);
+    painter->drawText(r.adjusted(5, 0, -5, 0), Qt::AlignLeft | Qt::AlignTop,
+                      QString("%1fps, max %2ms").arg(m_fps).arg(m_longestFrame, 0, 'f', 1));
+
+    // one bar per frame time bucket, the long frames are the interesting ones
+    int maxBucket = 1;
+    for (int i = 0; i < m_buckets.size(); ++i)
+        maxBucket = qMax(maxBucket, m_buckets.at(i));
+
+    QRectF histogramRect(r.adjusted(5, textHeight + 5, -5, -(textHeight + 5)));
+    qreal barWidth = histogramRect.width() / m_buckets.size();
+    for (int i = 0; i < m_buckets.size(); ++i) {
+        QColor color(i < s_fastBucketCount ? s_textColor : s_slowFrameColor);
+        qreal h = histogramRect.height() * m_buckets.at(i) / maxBucket;
+        QRectF bar(histogramRect.left() + i * barWidth, histogramRect.bottom() - h, barWidth - 2, h);
+        painter->fillRect(bar, color);
+
+        qreal bound = FrameStats::bucketUpperBound(i);
+        painter->setPen(color);
+        painter->drawText(QRectF(bar.left(), histogramRect.bottom(), barWidth, textHeight + 5), Qt::AlignCenter,
+                          bound < 0 ? QString(">") : QString::number(bound, 'f', 0));
+    }
+}
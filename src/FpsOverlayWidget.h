@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef FpsOverlayWidget_h_
+#define FpsOverlayWidget_h_
+
+#include "yberconfig.h"
+#include "FrameStats.h"
+
+#include <QGraphicsWidget>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+class WebView;
+
+class FpsOverlayWidget : public QGraphicsWidget {
+    Q_OBJECT
+public:
+    FpsOverlayWidget(QGraphicsItem* parent = 0);
+
+    void setWebView(WebView* webView);
+
+private Q_SLOTS:
+    void updateStats();
+
+private:
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget);
+
+    // closing the tab deletes the view
+    QPointer<WebView> m_webView;
+    QTimer m_updateTimer;
+    unsigned m_frameCount;
+    QVector<FrameStats::Frame> m_frames;
+    QVector<int> m_buckets;
+    int m_fps;
+    qreal m_longestFrame;
+};
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "FrameStats.h"
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_SYMBIAN)
+#include <time.h>
+#else
+#include <QTime>
+#endif
+
+// frame time histogram buckets in ms, the last one takes everything above
+static const qreal s_bucketLimits[] = {4, 8, 16.7, 33.3, 50, 100, -1};
+
+/*!
+  \class FrameStats keeps the timestamp and duration of the latest
+  frames in a fixed size ring buffer.
+
+  A single writer (the painting thread) records frames without
+  locking. Readers copy the frames out and drop the ones that got
+  overwritten while copying.
+*/
+FrameStats::FrameStats()
+    : m_written(0)
+{
+}
+
+/*!
+  Monotonic time in microseconds.
+*/
+qint64 FrameStats::now()
+{
+#if defined(Q_OS_UNIX) && !defined(Q_OS_SYMBIAN)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+    static QTime clock;
+    if (clock.isNull())
+        clock.start();
+    return qint64(clock.elapsed()) * 1000;
+#endif
+}
+
+void FrameStats::record(qint64 timestamp, qint64 duration)
+{
+    Frame& frame = m_frames[unsigned(int(m_written)) % Capacity];
+    frame.timestamp = timestamp;
+    frame.duration = duration;
+    // publish the frame
+    m_written.fetchAndAddRelease(1);
+}
+
+unsigned FrameStats::frameCount() const
+{
+    return m_written.fetchAndAddAcquire(0);
+}
+
+/*!
+  Appends the frames recorded after \a since to \a frames and returns
+  the frame count to pass as \a since on the next call.
+*/
+unsigned FrameStats::frames(unsigned since, QVector<Frame>& frames) const
+{
+    unsigned written = frameCount();
+    if (written - since > unsigned(Capacity))
+        since = written - Capacity;
+
+    int first = frames.size();
+    for (unsigned i = since; i != written; ++i)
+        frames.append(m_frames[i % Capacity]);
+
+    // the writer might have lapped us while copying
+    unsigned overwritten = frameCount() - Capacity;
+    if (int(overwritten - since) > 0)
+        frames.remove(first, qMin(int(overwritten - since), frames.size() - first));
+    return written;
+}
+
+void FrameStats::histogram(const QVector<Frame>& frames, QVector<int>& buckets)
+{
+    buckets.fill(0, bucketCount());
+    for (int i = 0; i < frames.size(); ++i) {
+        qreal ms = frames.at(i).duration / 1000.;
+        int bucket = 0;
+        while (bucket < bucketCount() - 1 && ms > s_bucketLimits[bucket])
+            ++bucket;
+        buckets[bucket]++;
+    }
+}
+
+int FrameStats::bucketCount()
+{
+    return sizeof(s_bucketLimits) / sizeof(qreal);
+}
+
+/*!
+  Upper bound of the \a bucket in ms, -1 for the last, open ended bucket.
+*/
+qreal FrameStats::bucketUpperBound(int bucket)
+{
+    return s_bucketLimits[bucket];
+}
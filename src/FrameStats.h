@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef FrameStats_h_
+#define FrameStats_h_
+
+#include <QAtomicInt>
+#include <QVector>
+
+class FrameStats {
+public:
+    struct Frame {
+        // microseconds, see now()
+        qint64 timestamp;
+        qint64 duration;
+    };
+
+    enum { Capacity = 512 };
+
+    FrameStats();
+
+    static qint64 now();
+
+    void record(qint64 timestamp, qint64 duration);
+
+    unsigned frameCount() const;
+    unsigned frames(unsigned since, QVector<Frame>& frames) const;
+    static void histogram(const QVector<Frame>& frames, QVector<int>& buckets);
+
+    static int bucketCount();
+    static qreal bucketUpperBound(int bucket);
+
+private:
+    Q_DISABLE_COPY(FrameStats)
+
+    Frame m_frames[Capacity];
+    mutable QAtomicInt m_written;
+};
+
+#endif
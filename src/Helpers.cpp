@@ -23,6 +23,8 @@
 #include "Settings.h"
 
 #include <QFileInfo>
+#include <QDir>
+#include <QRegExp>
 #include <QImage>
 #include <QPropertyAnimation>
 #include <QGraphicsWidget>
@@ -36,7 +38,9 @@
 #include <qwebframe.h>
 #include <QDebug>
 
-static int s_maxUrlItems = 50;
+// thumbnail levels stop at about the size of the smallest tile, see TileBaseWidget
+static const int s_minThumbnailLevelWidth = 160;
+static const int s_minThumbnailLevelHeight = 96;
 
 class NotificationWidget : public QGraphicsWidget {
     Q_OBJECT
@@ -138,7 +142,11 @@ void internalizeUrlList(UrlList& list, const QString& fileName, uint version)
     // version
     // number of items
     // url, refcount, lastaccess
-    QFile store(Settings::instance()->privatePath() + fileName);
+    QString path = Settings::instance()->privatePath() + fileName;
+    // externalizeUrlList() got interrupted between removing the old list and renaming the new one
+    if (!QFile::exists(path) && QFile::exists(path + ".tmp"))
+        QFile::rename(path + ".tmp", path);
+    QFile store(path);
 
     if (store.open(QFile::ReadWrite)) {
         QDataStream in(&store);
@@ -157,18 +165,96 @@ void internalizeUrlList(UrlList& list, const QString& fileName, uint version)
     }
 }
 
-void externalizeUrlList(UrlList& list, const QString& fileName, uint version)
+bool externalizeUrlList(UrlList& list, const QString& fileName, uint version)
 {
-    // FIXME: Clean up old thumbnail items that do not fit s_maxUrlItems now.
-    int count = qMin(list.size(), s_maxUrlItems);
-    QFile store(Settings::instance()->privatePath() + fileName);
-    if (store.open(QFile::WriteOnly | QIODevice::Truncate)) {
-        QDataStream out(&store);
-        out << version << count;
-        for (int i = 0; i < count; ++i)
-            list[i].externalize(out);
-        store.close();
+    int count = list.size();
+    QString path = Settings::instance()->privatePath() + fileName;
+    // write aside, a crash while writing must not lose the old list
+    QFile store(path + ".tmp");
+    if (!store.open(QFile::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream out(&store);
+    out << version << count;
+    for (int i = 0; i < count; ++i)
+        list[i].externalize(out);
+    store.close();
+    if (out.status() != QDataStream::Ok || store.error() != QFile::NoError) {
+        store.remove();
+        return false;
+    }
+    QFile::remove(path);
+    return store.rename(path);
+}
+
+/*!
+  Removes the thumbnail files in the private path that are not in
+  \a thumbnails.
+*/
+void removeUnusedThumbnails(const QSet<QString>& thumbnails)
+{
+    // only the files ThumbnailWriter creates, and the numbered ones of the old versions.
+    // raw copies go with their png
+    QRegExp thumbnailName("(\\d+|[0-9a-f]{32})\\.(png|raw)");
+    QDir dir(Settings::instance()->privatePath());
+    QStringList files = dir.entryList(QStringList() << "*.png" << "*.raw", QDir::Files);
+    for (int i = 0; i < files.size(); ++i) {
+        if (thumbnailName.exactMatch(files.at(i)) && !thumbnails.contains(thumbnailName.cap(1) + ".png"))
+            dir.remove(files.at(i));
+    }
+}
+
+/*!
+  Returns \a image at half the size, each pixel the average of four.
+*/
+QImage downscaleBox(const QImage& image)
+{
+    QImage source = image.format() == QImage::Format_RGB32 ? image : image.convertToFormat(QImage::Format_RGB32);
+    QImage scaled(source.width() / 2, source.height() / 2, QImage::Format_RGB32);
+    for (int y = 0; y < scaled.height(); ++y) {
+        const QRgb* line1 = reinterpret_cast<const QRgb*>(source.scanLine(2 * y));
+        const QRgb* line2 = reinterpret_cast<const QRgb*>(source.scanLine(2 * y + 1));
+        QRgb* dest = reinterpret_cast<QRgb*>(scaled.scanLine(y));
+        for (int x = 0; x < scaled.width(); ++x) {
+            QRgb p1 = line1[2 * x];
+            QRgb p2 = line1[2 * x + 1];
+            QRgb p3 = line2[2 * x];
+            QRgb p4 = line2[2 * x + 1];
+            // red and blue are summed in one go, the sums do not overflow to the next channel
+            quint32 rb = (p1 & 0xff00ff) + (p2 & 0xff00ff) + (p3 & 0xff00ff) + (p4 & 0xff00ff);
+            quint32 g = (p1 & 0xff00) + (p2 & 0xff00) + (p3 & 0xff00) + (p4 & 0xff00);
+            dest[x] = 0xff000000 | ((rb >> 2) & 0xff00ff) | ((g >> 2) & 0xff00);
+        }
+    }
+    return scaled;
+}
+
+/*!
+  Returns \a thumbnail followed by its box filtered halves, down to about
+  the size of the smallest tile.
+*/
+QList<QImage> thumbnailLevels(const QImage& thumbnail)
+{
+    QList<QImage> levels;
+    if (thumbnail.isNull())
+        return levels;
+    levels.append(thumbnail);
+    while (levels.last().width() / 2 >= s_minThumbnailLevelWidth && levels.last().height() / 2 >= s_minThumbnailLevelHeight)
+        levels.append(downscaleBox(levels.last()));
+    return levels;
+}
+
+/*!
+  Returns the smallest of \a levels that still covers \a size, at most
+  twice as big as needed.
+*/
+QImage thumbnailLevel(const QList<QImage>& levels, const QSize& size)
+{
+    for (int i = levels.size() - 1; i > 0; --i) {
+        if (levels.at(i).width() >= size.width() && levels.at(i).height() >= size.height())
+            return levels.at(i);
     }
+    return levels.isEmpty() ? QImage() : levels.first();
 }
 
 #include "Helpers.moc"
@@ -22,14 +22,21 @@
 #define Helpers_h_
 
 #include <QUrl>
+#include <QSet>
 #include "UrlItem.h"
 
 class QString;
+class QImage;
+class QSize;
 class QGraphicsWidget;
 
 void notification(const QString& text, QGraphicsWidget* parent);
 QUrl urlFromUserInput(const QString& string);
 void internalizeUrlList(UrlList& list, const QString& fileName, uint version);
-void externalizeUrlList(UrlList& list, const QString& fileName, uint version);
+bool externalizeUrlList(UrlList& list, const QString& fileName, uint version);
+void removeUnusedThumbnails(const QSet<QString>& thumbnails);
+QImage downscaleBox(const QImage& image);
+QList<QImage> thumbnailLevels(const QImage& thumbnail);
+QImage thumbnailLevel(const QList<QImage>& levels, const QSize& size);
 
 #endif
@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "HistoryArchive.h"
+#include "Settings.h"
+
+#include <QDataStream>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include <stdio.h>
+
+static const uint s_archiveVersion = 1;
+// dead records allowed in the log before it gets compacted
+static const int s_compactionSlack = 64;
+// the least ranked items are forgotten past this, it bounds the index and the log
+static const int s_maxArchivedItems = 5000;
+
+/*!
+  \class HistoryArchive keeps the history items that dropped out of the
+  in-memory HistoryStore list.
+
+  The items are kept in an append-only log of add and remove records.
+  Only the offsets and the ranks of the items, and the HistoryIndex of
+  their hosts and words, are kept in memory, an item is read from the log
+  when asked for. The log is read in a worker thread after startLoading(),
+  and rewritten without the dead records in another once they outnumber
+  the live ones.
+*/
+HistoryArchive::HistoryArchive(const QString& fileName)
+    : m_fileName(fileName)
+    , m_loaded(false)
+    , m_readingStarted(false)
+    , m_records(0)
+    , m_compacting(false)
+{
+}
+
+QString HistoryArchive::path() const
+{
+    return Settings::instance()->privatePath() + m_fileName;
+}
+
+/*!
+  Starts reading the log in a worker thread, finishLoading() picks the
+  items up once it is done. Until then the archive is empty, the changes
+  are logged and applied over what the reader found.
+*/
+QFuture<HistoryArchive::Contents> HistoryArchive::startLoading()
+{
+    if (!m_loaded && !m_readingStarted) {
+        m_reading = QtConcurrent::run(read, path());
+        m_readingStarted = true;
+    }
+    return m_reading;
+}
+
+void HistoryArchive::finishLoading()
+{
+    if (m_loaded || !m_readingStarted || !m_reading.isFinished())
+        return;
+    m_loaded = true;
+    m_readingStarted = false;
+
+    Contents contents = m_reading.result();
+    m_entries = contents.entries;
+    m_index = contents.index;
+    m_records = contents.records;
+    QHash<QString, Entry>::const_iterator it = m_entries.constBegin();
+    for (; it != m_entries.constEnd(); ++it)
+        m_ranks.insert(rank(*it), it.key());
+
+    for (int i = 0; i < m_changesWhileReading.size(); ++i) {
+        const Change& change = m_changesWhileReading.at(i);
+        // the reader may have seen the change already
+        removeEntry(change.key);
+        if (change.type == AddRecord && change.offset >= 0) {
+            Entry entry;
+            entry.offset = change.offset;
+            entry.refcount = change.item.refcount;
+            entry.lastAccess = change.item.lastAccess;
+            insertEntry(change.key, entry, change.item);
+        }
+    }
+    m_changesWhileReading.clear();
+    evict();
+    compactIfNeeded();
+}
+
+/*!
+  Reads the item with \a key from the log, returns an empty item if
+  there is no such item.
+*/
+HistoryArchive::Item HistoryArchive::item(const QString& key)
+{
+    Item item;
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(key);
+    if (it != m_entries.constEnd())
+        readItem(it->offset, &item);
+    return item;
+}
+
+void HistoryArchive::add(const QString& key, const Item& item)
+{
+    finishCompaction();
+    qint64 offset = append(AddRecord, key, item);
+    if (!m_loaded) {
+        if (m_readingStarted) {
+            Change change = { AddRecord, key, item, offset };
+            m_changesWhileReading.append(change);
+        }
+        return;
+    }
+
+    removeEntry(key);
+    if (offset >= 0) {
+        Entry entry;
+        entry.offset = offset;
+        entry.refcount = item.refcount;
+        entry.lastAccess = item.lastAccess;
+        insertEntry(key, entry, item);
+    }
+    if (m_compacting)
+        m_changesWhileCompacting.insert(key);
+    evict();
+    compactIfNeeded();
+}
+
+void HistoryArchive::remove(const QString& key)
+{
+    finishCompaction();
+    if (!m_loaded) {
+        // not known if it is there, the record does no harm if not
+        append(RemoveRecord, key, Item());
+        if (m_readingStarted) {
+            Change change = { RemoveRecord, key, Item(), -1 };
+            m_changesWhileReading.append(change);
+        }
+        return;
+    }
+
+    if (!m_entries.contains(key))
+        return;
+    removeEntry(key);
+    append(RemoveRecord, key, Item());
+    if (m_compacting)
+        m_changesWhileCompacting.insert(key);
+    compactIfNeeded();
+}
+
+void HistoryArchive::insertEntry(const QString& key, const Entry& entry, const Item& item)
+{
+    m_entries.insert(key, entry);
+    m_ranks.insert(rank(entry), key);
+    m_index.add(item.url, item.title, key);
+}
+
+void HistoryArchive::removeEntry(const QString& key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+    Item item;
+    if (readItem(it->offset, &item))
+        m_index.remove(item.url, item.title, key);
+    m_ranks.remove(rank(*it), key);
+    m_entries.erase(it);
+}
+
+void HistoryArchive::evict()
+{
+    while (m_entries.size() > s_maxArchivedItems)
+        remove(m_ranks.begin().value());
+}
+
+/*!
+  Appends a record to the log, returns its offset or -1 if it could not
+  be written.
+*/
+qint64 HistoryArchive::append(RecordType type, const QString& key, const Item& item)
+{
+    QFile log(path());
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append))
+        return -1;
+
+    QDataStream out(&log);
+    if (!log.size())
+        out << s_archiveVersion;
+    qint64 offset = log.pos();
+    writeRecord(out, type, key, item);
+    log.close();
+
+    m_records++;
+    return out.status() == QDataStream::Ok ? offset : -1;
+}
+
+bool HistoryArchive::readItem(qint64 offset, Item* item)
+{
+    if (offset < 0)
+        return false;
+    if (!m_log.isOpen()) {
+        m_log.setFileName(path());
+        if (!m_log.open(QIODevice::ReadOnly))
+            return false;
+    }
+    if (!m_log.seek(offset))
+        return false;
+    QDataStream in(&m_log);
+    quint8 type;
+    QString key;
+    return readRecord(in, &type, &key, item) && type == AddRecord;
+}
+
+HistoryArchive::Contents HistoryArchive::read(const QString& path)
+{
+    Contents contents;
+    QFile log(path);
+    if (!log.open(QIODevice::ReadOnly))
+        return contents;
+
+    QDataStream in(&log);
+    uint version;
+    in >> version;
+    if (version != s_archiveVersion)
+        return contents;
+
+    // only until the index is built
+    QHash<QString, Item> items;
+    while (!in.atEnd()) {
+        qint64 offset = log.pos();
+        quint8 type;
+        QString key;
+        Item item;
+        // a record cut short by a crash ends the log
+        if (!readRecord(in, &type, &key, &item))
+            break;
+
+        if (type == AddRecord) {
+            Entry entry;
+            entry.offset = offset;
+            entry.refcount = item.refcount;
+            entry.lastAccess = item.lastAccess;
+            contents.entries.insert(key, entry);
+            items.insert(key, item);
+        } else {
+            contents.entries.remove(key);
+            items.remove(key);
+        }
+        contents.records++;
+    }
+
+    QHash<QString, Item>::const_iterator it = items.constBegin();
+    for (; it != items.constEnd(); ++it)
+        contents.index.add(it->url, it->title, it.key());
+    return contents;
+}
+
+bool HistoryArchive::readRecord(QDataStream& in, quint8* type, QString* key, Item* item)
+{
+    in >> *type >> *key;
+    if (*type == AddRecord)
+        in >> item->url >> item->title >> item->refcount >> item->lastAccess;
+    return in.status() == QDataStream::Ok;
+}
+
+void HistoryArchive::writeRecord(QDataStream& out, RecordType type, const QString& key, const Item& item)
+{
+    out << quint8(type) << key;
+    if (type == AddRecord)
+        out << item.url << item.title << item.refcount << item.lastAccess;
+}
+
+quint64 HistoryArchive::rank(const Entry& entry)
+{
+    return (quint64(entry.refcount) << 32) | entry.lastAccess;
+}
+
+void HistoryArchive::compactIfNeeded()
+{
+    if (m_loaded && !m_compacting && m_records > 2 * m_entries.size() + s_compactionSlack) {
+        m_changesWhileCompacting.clear();
+        m_compaction = QtConcurrent::run(compact, path(), m_entries);
+        m_compacting = true;
+    }
+}
+
+/*!
+  Copies the live records of \a entries to a new log next to the one at
+  \a path, in a worker thread. finishCompaction() puts it in place.
+*/
+HistoryArchive::Compaction HistoryArchive::compact(const QString& path, const QHash<QString, Entry>& entries)
+{
+    Compaction compaction;
+    QFile log(path);
+    QFile compacted(path + ".tmp");
+    if (!log.open(QIODevice::ReadOnly) || !compacted.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return compaction;
+
+    QDataStream in(&log);
+    QDataStream out(&compacted);
+    out << s_archiveVersion;
+    QHash<QString, Entry>::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it) {
+        quint8 type;
+        QString key;
+        Item item;
+        if (it->offset < 0 || !log.seek(it->offset) || !readRecord(in, &type, &key, &item) || type != AddRecord)
+            continue;
+        compaction.offsets.insert(it.key(), compacted.pos());
+        writeRecord(out, AddRecord, it.key(), item);
+    }
+    compacted.close();
+    if (out.status() != QDataStream::Ok || compacted.error() != QFile::NoError) {
+        compacted.remove();
+        return compaction;
+    }
+    compaction.written = true;
+    return compaction;
+}
+
+/*!
+  Adds the changes made while compacting to the compacted log and
+  replaces the log with it.
+*/
+void HistoryArchive::finishCompaction()
+{
+    if (!m_compacting || !m_compaction.isFinished())
+        return;
+    m_compacting = false;
+    Compaction compaction = m_compaction.result();
+    QSet<QString> changed = m_changesWhileCompacting;
+    m_changesWhileCompacting.clear();
+    if (!compaction.written)
+        return;
+
+    QString tmpPath = path() + ".tmp";
+    QFile compacted(tmpPath);
+    if (!compacted.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QFile::remove(tmpPath);
+        return;
+    }
+    QDataStream out(&compacted);
+    int records = compaction.offsets.size() + changed.size();
+    QSet<QString>::const_iterator key = changed.constBegin();
+    for (; key != changed.constEnd(); ++key) {
+        Item item;
+        if (m_entries.contains(*key) && readItem(m_entries.value(*key).offset, &item)) {
+            compaction.offsets.insert(*key, compacted.pos());
+            writeRecord(out, AddRecord, *key, item);
+        } else {
+            compaction.offsets.remove(*key);
+            writeRecord(out, RemoveRecord, *key, Item());
+        }
+    }
+    compacted.close();
+    if (out.status() != QDataStream::Ok || compacted.error() != QFile::NoError) {
+        QFile::remove(tmpPath);
+        return;
+    }
+    // unlike QFile::rename, replaces the old log atomically
+    if (::rename(QFile::encodeName(tmpPath).constData(), QFile::encodeName(path()).constData())) {
+        qWarning() << "HistoryArchive: cannot replace" << path();
+        QFile::remove(tmpPath);
+        return;
+    }
+
+    // the offsets are into the new log from now on
+    m_log.close();
+    QHash<QString, Entry>::iterator it = m_entries.begin();
+    for (; it != m_entries.end(); ++it)
+        it->offset = compaction.offsets.value(it.key(), -1);
+    m_records = records;
+}
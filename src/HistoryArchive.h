@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef HistoryArchive_h_
+#define HistoryArchive_h_
+
+#include <QFile>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMultiMap>
+#include <QSet>
+#include <QString>
+#include "HistoryIndex.h"
+
+class HistoryArchive {
+public:
+    struct Item {
+        Item() : refcount(0), lastAccess(0) {}
+        QString url;
+        QString title;
+        uint refcount;
+        uint lastAccess;
+    };
+
+    // where the item is in the log, and what it takes to rank it
+    struct Entry {
+        Entry() : offset(-1), refcount(0), lastAccess(0) {}
+        qint64 offset;
+        uint refcount;
+        uint lastAccess;
+    };
+
+    struct Contents {
+        Contents() : records(0) {}
+        QHash<QString, Entry> entries;
+        HistoryIndex index;
+        int records;
+    };
+
+    explicit HistoryArchive(const QString& fileName);
+
+    bool isLoaded() const { return m_loaded; }
+    QFuture<Contents> startLoading();
+    void finishLoading();
+
+    // empty until loaded
+    bool contains(const QString& key) const { return m_entries.contains(key); }
+    Entry entry(const QString& key) const { return m_entries.value(key); }
+    const HistoryIndex& index() const { return m_index; }
+    Item item(const QString& key);
+
+    void add(const QString& key, const Item& item);
+    void remove(const QString& key);
+
+private:
+    enum RecordType {
+        AddRecord,
+        RemoveRecord
+    };
+
+    struct Change {
+        RecordType type;
+        QString key;
+        Item item;
+        qint64 offset;
+    };
+
+    struct Compaction {
+        Compaction() : written(false) {}
+        bool written;
+        QHash<QString, qint64> offsets;
+    };
+
+    QString path() const;
+    qint64 append(RecordType type, const QString& key, const Item& item);
+    bool readItem(qint64 offset, Item* item);
+    void insertEntry(const QString& key, const Entry& entry, const Item& item);
+    void removeEntry(const QString& key);
+    void evict();
+    void compactIfNeeded();
+    void finishCompaction();
+
+    static Contents read(const QString& path);
+    static Compaction compact(const QString& path, const QHash<QString, Entry>& entries);
+    static bool readRecord(QDataStream& in, quint8* type, QString* key, Item* item);
+    static void writeRecord(QDataStream& out, RecordType type, const QString& key, const Item& item);
+    static quint64 rank(const Entry& entry);
+
+    QString m_fileName;
+    bool m_loaded;
+    QFuture<Contents> m_reading;
+    bool m_readingStarted;
+    // changes made while the log is read, the reader may miss them
+    QList<Change> m_changesWhileReading;
+    // index key -> entry, the items themselves stay in the log
+    QHash<QString, Entry> m_entries;
+    // rank -> index key, the least ranked first
+    QMultiMap<quint64, QString> m_ranks;
+    HistoryIndex m_index;
+    // for the single record reads, reopened once a compaction replaced the log
+    QFile m_log;
+    // records in the log, live or not
+    int m_records;
+    QFuture<Compaction> m_compaction;
+    bool m_compacting;
+    // keys added or removed while compacting, the compacted log is missing those
+    QSet<QString> m_changesWhileCompacting;
+};
+
+#endif
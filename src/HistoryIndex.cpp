@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "HistoryIndex.h"
+
+#include <QUrl>
+
+// lower case words of letters and numbers
+static QStringList tokenize(const QString& text)
+{
+    QStringList tokens;
+    QString token;
+    for (int i = 0; i <= text.size(); ++i) {
+        if (i < text.size() && text.at(i).isLetterOrNumber()) {
+            token.append(text.at(i).toLower());
+        } else if (!token.isEmpty()) {
+            tokens.append(token);
+            token.clear();
+        }
+    }
+    tokens.removeDuplicates();
+    return tokens;
+}
+
+static QStringList itemWords(const QString& url, const QString& title)
+{
+    int schemeEnd = url.indexOf("://");
+    return tokenize((schemeEnd == -1 ? url : url.mid(schemeEnd + 3)) + " " + title);
+}
+
+/*!
+  \class HistoryIndex finds history items by host and by the words of
+  their urls and titles. Only the index keys are kept, no items.
+
+  The lookups are plain functions of the url and the title, the archive
+  builds its index in a worker thread.
+*/
+void HistoryIndex::add(const QString& url, const QString& title, const QString& key)
+{
+    addHost(QUrl(url).host(), key);
+    QStringList words = itemWords(url, title);
+    for (int i = 0; i < words.size(); ++i)
+        m_words[words.at(i)].append(key);
+}
+
+void HistoryIndex::remove(const QString& url, const QString& title, const QString& key)
+{
+    removeHost(QUrl(url).host(), key);
+    QStringList words = itemWords(url, title);
+    for (int i = 0; i < words.size(); ++i) {
+        QMap<QString, QStringList>::iterator it = m_words.find(words.at(i));
+        if (it == m_words.end())
+            continue;
+        it.value().removeOne(key);
+        if (it.value().isEmpty())
+            m_words.erase(it);
+    }
+}
+
+void HistoryIndex::clear()
+{
+    m_hosts.clear();
+    m_words.clear();
+}
+
+QSet<QString> HistoryIndex::keysForPrefix(const QString& prefix) const
+{
+    QSet<QString> keys;
+    QMap<QString, QStringList>::const_iterator it = m_words.lowerBound(prefix);
+    for (; it != m_words.constEnd() && it.key().startsWith(prefix); ++it) {
+        const QStringList& wordKeys = it.value();
+        for (int i = 0; i < wordKeys.size(); ++i)
+            keys.insert(wordKeys.at(i));
+    }
+    return keys;
+}
+
+/*!
+  Returns the words of the typed \a text. The scheme is not indexed, and
+  "www." would only narrow the match down to the www hosts.
+*/
+QStringList HistoryIndex::queryWords(const QString& text)
+{
+    QString query = text.trimmed();
+    int schemeEnd = query.indexOf("://");
+    if (schemeEnd != -1)
+        query = query.mid(schemeEnd + 3);
+    if (query.startsWith("www.", Qt::CaseInsensitive))
+        query = query.mid(4);
+    return tokenize(query);
+}
+
+void HistoryIndex::addHost(const QString& host, const QString& key)
+{
+    m_hosts[host].append(key);
+    if (host.startsWith("www."))
+        m_hosts[host.mid(4)].append(key);
+}
+
+void HistoryIndex::removeHost(const QString& host, const QString& key)
+{
+    QStringList hosts(host);
+    if (host.startsWith("www."))
+        hosts.append(host.mid(4));
+    for (int i = 0; i < hosts.size(); ++i) {
+        QMap<QString, QStringList>::iterator it = m_hosts.find(hosts.at(i));
+        if (it == m_hosts.end())
+            continue;
+        it.value().removeOne(key);
+        if (it.value().isEmpty())
+            m_hosts.erase(it);
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef HistoryIndex_h_
+#define HistoryIndex_h_
+
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class HistoryIndex {
+public:
+    void add(const QString& url, const QString& title, const QString& key);
+    void remove(const QString& url, const QString& title, const QString& key);
+    void clear();
+
+    // host, and host without "www." -> index keys, sorted for prefix lookups
+    const QMap<QString, QStringList>& hosts() const { return m_hosts; }
+    QSet<QString> keysForPrefix(const QString& prefix) const;
+
+    static QStringList queryWords(const QString& text);
+
+private:
+    void addHost(const QString& host, const QString& key);
+    void removeHost(const QString& host, const QString& key);
+
+    QMap<QString, QStringList> m_hosts;
+    // words of the urls and titles -> index keys, sorted for prefix lookups
+    QMap<QString, QStringList> m_words;
+};
+
+#endif
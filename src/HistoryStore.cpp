@@ -19,18 +19,55 @@
  */
 
 #include "HistoryStore.h"
+#include "BookmarkStore.h"
 #include "Helpers.h"
+#include "ThumbnailWriter.h"
 
 #include <QDateTime>
 #include <QImage>
 #include <QTimer>
-#include <QRegExp>
 #include <QDebug>
 
 //#define ENABLE_HISTORYSTORE_DEBUG 1
 
 static uint s_currentVersion = 3;
+// items kept in memory (with thumbnails), the rest are archived
+static const int s_maxHotItems = 50;
+// archive and thumbnail cleanup are not needed for startup
+static const int s_startupCleanupDelay = 5000;
+// changes are journaled right away, the whole list is written this much later
+static const int s_externalizeDelay = 30000;
+static const int s_maxJournalRecords = 50;
 
+struct HistoryStore::RankedKey {
+    QString key;
+    uint refcount;
+    uint lastAccess;
+};
+
+// most accessed first, recently accessed first among the equals
+bool HistoryStore::rankedBefore(const RankedKey& key1, const RankedKey& key2)
+{
+    if (key1.refcount != key2.refcount)
+        return key1.refcount > key2.refcount;
+    return key1.lastAccess > key2.lastAccess;
+}
+
+static bool itemRankedBefore(const UrlItem& item1, const UrlItem& item2)
+{
+    if (item1.refcount() != item2.refcount())
+        return item1.refcount() > item2.refcount();
+    return item1.lastAccess() > item2.lastAccess();
+}
+
+/*!
+  \class HistoryStore keeps the browsing history.
+
+  The most accessed items live in memory with their thumbnails, list()
+  returns them. Items dropping out of the list go to the HistoryArchive
+  without thumbnails, they are still found by match() and come back to
+  the list when accessed again.
+*/
 HistoryStore* HistoryStore::instance()
 {
     static HistoryStore* historyStore = 0;
@@ -40,146 +77,428 @@ HistoryStore* HistoryStore::instance()
 }
 
 HistoryStore::HistoryStore()
-    : m_needsPersisting(false)
+    : m_archive("historyarchive.log")
+    , m_journal("historystore.journal")
+    , m_needsPersisting(false)
+    , m_thumbnailsOrphaned(true)
 {
+    m_externalizeTimer.setSingleShot(true);
+    m_externalizeTimer.setInterval(s_externalizeDelay);
+    connect(&m_externalizeTimer, SIGNAL(timeout()), this, SLOT(externalize()));
+    connect(ThumbnailWriter::instance(), SIGNAL(thumbnailSaved(const QString&, bool)), this, SLOT(thumbnailSaved(const QString&, bool)));
+    connect(&m_archiveWatcher, SIGNAL(finished()), this, SLOT(archiveRead()));
+
     internalizeUrlList(m_list, "historystore.txt", s_currentVersion);
+    if (m_journal.replay(m_list)) {
+        // replayed items come in change order, sort them back to rank order
+        qStableSort(m_list.begin(), m_list.end(), itemRankedBefore);
+        externalizeSoon();
+    }
     if (!m_list.size()) {
 #if defined(ENABLE_HISTORYSTORE_DEBUG)
         qDebug() << "HistoryStore: no url store, use default values";
 #endif
         // init historystore with some popular urls. prefer non-www for to save space
-        m_list.append(UrlItem(QUrl("http://cnn.com/"), "CNN.com - Breaking News, U.S., World, Weather, Entertainment &amp; Video News", 0));
-        m_list.append(UrlItem(QUrl("http://news.bbc.co.uk/"), "BBC NEWS | News Front Page", 0));
-        m_list.append(UrlItem(QUrl("http://news.google.com/"), "Google News", 0));
-        m_list.append(UrlItem(QUrl("http://nokia.com/"), "Nokia - Nokia on the Web", 0));
-        m_list.append(UrlItem(QUrl("http://qt.nokia.com/"), "Qt - A cross-platform application and UI framework", 0));
-        m_list.append(UrlItem(QUrl("http://ovi.com/"), "Ovi by Nokia", 0));
-        m_list.append(UrlItem(QUrl("http://nytimes.com/"), "The New York Times - Breaking News, World News Multimedia", 0));
-        m_list.append(UrlItem(QUrl("http://google.com/"), "Google", 0));
+        m_list.append(UrlItem(QUrl("http://cnn.com/"), "CNN.com - Breaking News, U.S., World, Weather, Entertainment &amp; Video News"));
+        m_list.append(UrlItem(QUrl("http://news.bbc.co.uk/"), "BBC NEWS | News Front Page"));
+        m_list.append(UrlItem(QUrl("http://news.google.com/"), "Google News"));
+        m_list.append(UrlItem(QUrl("http://nokia.com/"), "Nokia - Nokia on the Web"));
+        m_list.append(UrlItem(QUrl("http://qt.nokia.com/"), "Qt - A cross-platform application and UI framework"));
+        m_list.append(UrlItem(QUrl("http://ovi.com/"), "Ovi by Nokia"));
+        m_list.append(UrlItem(QUrl("http://nytimes.com/"), "The New York Times - Breaking News, World News Multimedia"));
+        m_list.append(UrlItem(QUrl("http://google.com/"), "Google"));
     }
+    buildIndex();
+    QTimer::singleShot(s_startupCleanupDelay, this, SLOT(startupCleanup()));
 }
 
 // FIXME: this is a singleton, dont get properly deleted
 HistoryStore::~HistoryStore()
 {
     externalize();
+    ThumbnailWriter::instance()->flush();
 }
 
 void HistoryStore::externalize()
 {
+    m_externalizeTimer.stop();
     if (!m_needsPersisting)
         return;
-    externalizeUrlList(m_list, "historystore.txt", s_currentVersion);
+    // the journal has the changes until the list is safely written
+    if (!externalizeUrlList(m_list, "historystore.txt", s_currentVersion))
+        return;
+    m_journal.clear();
     m_needsPersisting = false;
+
+    // thumbnails of archived and removed items are not referenced by the store anymore
+    if (m_thumbnailsOrphaned)
+        removeOrphanThumbnails();
+}
+
+/*!
+  The store refers to thumbnail files before they are written, the ones
+  that never make it to the disk are dropped from the items. The written
+  ones are left to the ThumbnailCache.
+*/
+void HistoryStore::thumbnailSaved(const QString& path, bool ok)
+{
+    for (int i = 0; i < m_list.size(); ++i) {
+        if (m_list.at(i).thumbnailPath() != path)
+            continue;
+        if (ok) {
+            // loads from the disk again when needed
+            m_list[i].releaseThumbnail();
+            continue;
+        }
+        m_list[i].thumbnailSaveFailed();
+        m_journal.itemChanged(m_list[i]);
+        externalizeSoon();
+    }
 }
 
-void HistoryStore::accessed(const QUrl& url, const QString& title, QImage* thumbnail)
+void HistoryStore::startupCleanup()
 {
-    QString accessedHostAndPath = url.host() + url.path();
-    int found = -1;
+    // indexed in archiveRead(), until then match() sees only the list
+    m_archiveWatcher.setFuture(m_archive.startLoading());
+    if (!m_needsPersisting)
+        removeOrphanThumbnails();
+}
+
+/*!
+  The urls visited before the archive was read came in as new items, the
+  archived visits of those are added to them.
+*/
+void HistoryStore::archiveRead()
+{
+    m_archive.finishLoading();
+    bool merged = false;
+    for (int i = 0; i < m_list.size(); ++i) {
+        const QString& key = m_keys.at(i);
+        if (!m_archive.contains(key))
+            continue;
+        // otherwise the list wins, the item was never removed from the archive
+        if (m_visitedBeforeArchive.contains(key)) {
+            HistoryArchive::Entry archived = m_archive.entry(key);
+            UrlItem& item = m_list[i];
+            item.setRefcount(item.refcount() + archived.refcount);
+            item.setLastAccess(qMax(item.lastAccess(), archived.lastAccess));
+            m_journal.itemChanged(item);
+            merged = true;
+        }
+        m_archive.remove(key);
+    }
+    m_visitedBeforeArchive.clear();
+    if (merged) {
+        // back to the rank order
+        buildIndex();
+        externalizeSoon();
+    }
+}
+
+void HistoryStore::removeOrphanThumbnails()
+{
+    QSet<QString> thumbnails;
+    for (int i = 0; i < m_list.size(); ++i)
+        thumbnails.insert(m_list.at(i).thumbnailPath());
+    const UrlList& bookmarks = BookmarkStore::instance()->list();
+    for (int i = 0; i < bookmarks.size(); ++i)
+        thumbnails.insert(bookmarks.at(i).thumbnailPath());
+    removeUnusedThumbnails(thumbnails);
+    m_thumbnailsOrphaned = false;
+}
+
+void HistoryStore::accessed(const QUrl& url, const QString& title, const QList<QImage>& thumbnailLevels)
+{
+    QString key = indexKey(url);
+    int found = position(key);
 #if defined(ENABLE_HISTORYSTORE_DEBUG)
-    qDebug() << "HistoryStore:" << __FUNCTION__ << accessedHost;
+    qDebug() << "HistoryStore:" << __FUNCTION__ << key << found;
 #endif
-    for (int i = 0; i < m_list.size(); ++i) {
-        UrlItem& item = m_list[i];
-        if (matchUrls(item.url().host() + item.url().path(), accessedHostAndPath)) {
-            item.setRefcount(item.refcount() + 1);
-            item.setLastAccess(QDateTime::currentDateTime().toTime_t());
-            // move it up if needed
-            int j = i;
-            // '<=' is for the last access sorting, recently used items move up
-            while (--j >= 0 && item.refcount() >= m_list.at(j).refcount()) {}
-            // position adjusting and check whether we really moved
-            if (++j != i)
-                m_list.move(i, j);
-            found = j;
-            break;
+    if (found != -1) {
+        UrlItem& item = m_list[found];
+        item.setRefcount(item.refcount() + 1);
+        item.setLastAccess(QDateTime::currentDateTime().toTime_t());
+        m_ranks[key] = rank(item);
+        // move it up if needed
+        int j = found;
+        // '<=' is for the last access sorting, recently used items move up
+        while (--j >= 0 && item.refcount() >= m_list.at(j).refcount()) {}
+        // position adjusting and check whether we really moved
+        if (++j != found) {
+            m_list.move(found, j);
+            m_keys.move(found, j);
         }
+        found = j;
+    } else if (m_archive.contains(key)) {
+        // back from the archive, keeps its refcount
+        HistoryArchive::Entry archived = m_archive.entry(key);
+        m_archive.remove(key);
+        UrlItem item(url, title, thumbnailLevels);
+        item.setRefcount(archived.refcount + 1);
+        int i = m_list.size();
+        while (--i >= 0 && item.refcount() >= m_list.at(i).refcount()) {}
+        insertItem(++i, item, key);
+        found = i;
+    } else if (!m_archive.isLoaded()) {
+        // may be in the archive, merged in archiveRead()
+        m_visitedBeforeArchive.insert(key);
     }
 
     if (found == -1) {
         // insert to the top of the 1 refcount items. recently used sort
-        int i = m_list.size();
-        while (--i >= 0 && m_list[i].refcount() == 1) {}
-        m_list.insert(++i, UrlItem(url, title, thumbnail));
-    } else if (thumbnail) {
+        found = m_list.size();
+        while (--found >= 0 && m_list[found].refcount() == 1) {}
+        insertItem(++found, UrlItem(url, title, thumbnailLevels), key);
+    } else if (!thumbnailLevels.isEmpty()) {
         // add thumbnail if not there yet
-        m_list[found].setThumbnail(thumbnail);
+        m_list[found].setThumbnail(thumbnailLevels);
     }
+    m_journal.itemChanged(m_list[found]);
+
+    while (m_list.size() > s_maxHotItems)
+        archiveItem(m_list.size() - 1);
 #if defined(ENABLE_HISTORYSTORE_DEBUG)
     for (int i = 0; i < m_list.size(); ++i)
-        qDebug()<<m_list[i].m_url.toString()<<" "<<m_list[i].m_refcount;
+        qDebug()<<m_list[i].url().toString()<<" "<<m_list[i].refcount();
 #endif
     externalizeSoon();
 }
 
+/*!
+  Returns true if \a url is in list(), archived items don't count as
+  they have no thumbnail.
+*/
 bool HistoryStore::contains(const QString& url)
 {
-    for (int i = 0; i < m_list.size(); ++i)
-        if (m_list[i].url().toString() == url)
-            return true;
-    return false;
+    QUrl u(url);
+    int i = position(indexKey(u));
+    return i != -1 && m_list.at(i).url().toString() == url;
 }
 
-QString HistoryStore::match(const QString& url)
+/*!
+  Returns the host of the most accessed item that starts with \a url, the
+  host is matched both with and without "www.". The url of that item is
+  stored in \a matchedUrl if given.
+*/
+QString HistoryStore::match(const QString& url, QUrl* matchedUrl)
 {
     if (url.isEmpty())
         return QString();
-    for (int i = 0; i < m_list.size(); ++i) {
-        // do a very simply startWith matching first.
-        QString host = m_list[i].url().host();
-        if (host.startsWith(url))
-            return host;
-        else if (host.startsWith("www.")) {
-            host = host.mid(4);
-            if (host.startsWith(url))
-                return host;
+
+    QString matchedHost;
+    RankedKey best;
+    const QMap<QString, QStringList>* hosts[] = { &m_index.hosts(), &m_archive.index().hosts() };
+    for (int h = 0; h < 2; ++h) {
+        QMap<QString, QStringList>::const_iterator it = hosts[h]->lowerBound(url);
+        for (; it != hosts[h]->constEnd() && it.key().startsWith(url); ++it) {
+            const QStringList& keys = it.value();
+            for (int i = 0; i < keys.size(); ++i) {
+                RankedKey ranked = rankedKey(keys.at(i));
+                if (matchedHost.isEmpty() || rankedBefore(ranked, best)) {
+                    best = ranked;
+                    matchedHost = it.key();
+                }
+            }
         }
     }
-    return QString();
+    if (matchedUrl && !matchedHost.isEmpty()) {
+        int pos = position(best.key);
+        *matchedUrl = pos != -1 ? m_list.at(pos).url() : QUrl(m_archive.item(best.key).url);
+    }
+    return matchedHost;
 }
 
-void HistoryStore::match(const QString& url, UrlList& matchedItems)
+/*!
+  Appends the \a maxItems best ranked items that have words starting with
+  each of the words in \a text to \a matchedItems.
+*/
+void HistoryStore::match(const QString& text, UrlList& matchedItems, int maxItems)
 {
-    // FIXME should do some crazy regexp, for now just be stupid
-    if (url.isEmpty())
+    QStringList words = HistoryIndex::queryWords(text);
+    if (words.isEmpty())
         return;
-    QString text = url;
-    text.replace(" ", "|");
-    QRegExp rx(text);
-    for (int i = 0; i < m_list.size(); ++i) {
-        const UrlItem& item = m_list[i];
-        if (item.url().toString().indexOf(rx) > -1 || item.title().indexOf(rx) > -1)
-           matchedItems.append(m_list.at(i));
+
+    QSet<QString> keys = keysForPrefix(words.at(0));
+    for (int i = 1; i < words.size() && !keys.isEmpty(); ++i)
+        keys.intersect(keysForPrefix(words.at(i)));
+
+    // a short prefix matches most of the history, only the best maxItems
+    // are kept in order instead of sorting all of them
+    QList<RankedKey> ranked;
+    QSet<QString>::const_iterator it = keys.constBegin();
+    for (; it != keys.constEnd() && maxItems > 0; ++it) {
+        RankedKey candidate = rankedKey(*it);
+        if (ranked.size() == maxItems && !rankedBefore(candidate, ranked.last()))
+            continue;
+        ranked.insert(qUpperBound(ranked.begin(), ranked.end(), candidate, rankedBefore) - ranked.begin(), candidate);
+        if (ranked.size() > maxItems)
+            ranked.removeLast();
+    }
+
+    for (int i = 0; i < ranked.size(); ++i) {
+        int pos = position(ranked.at(i).key);
+        if (pos != -1) {
+            matchedItems.append(m_list.at(pos));
+            continue;
+        }
+        HistoryArchive::Item archived = m_archive.item(ranked.at(i).key);
+        if (archived.url.isEmpty())
+            continue;
+        UrlItem item(QUrl(archived.url), archived.title);
+        item.setRefcount(archived.refcount);
+        item.setLastAccess(archived.lastAccess);
+        matchedItems.append(item);
+    }
+}
+
+QSet<QString> HistoryStore::keysForPrefix(const QString& prefix) const
+{
+    return m_index.keysForPrefix(prefix).unite(m_archive.index().keysForPrefix(prefix));
+}
+
+HistoryStore::RankedKey HistoryStore::rankedKey(const QString& key) const
+{
+    RankedKey ranked;
+    ranked.key = key;
+    QHash<QString, quint64>::const_iterator it = m_ranks.constFind(key);
+    if (it != m_ranks.constEnd()) {
+        ranked.refcount = *it >> 32;
+        ranked.lastAccess = *it & 0xffffffff;
+    } else {
+        HistoryArchive::Entry archived = m_archive.entry(key);
+        ranked.refcount = archived.refcount;
+        ranked.lastAccess = archived.lastAccess;
     }
+    return ranked;
 }
 
 void HistoryStore::remove(const QUrl& url)
 {
-    for (int i = 0; i < m_list.size(); ++i) {
-        if (m_list[i].url() == url) {
+    QString key = indexKey(url);
+    int i = position(key);
+    if (i != -1 && m_list.at(i).url() == url) {
+        m_journal.itemRemoved(url);
+        removeItem(i);
+        m_thumbnailsOrphaned = true;
+        externalizeSoon();
+        return;
+    }
+
+    // not read yet, the removal is applied once it is
+    if (!m_archive.isLoaded() || m_archive.item(key).url == url.toString())
+        m_archive.remove(key);
+}
+
+/*!
+  Items are looked up by host and path, www.cnn.com/news and cnn.com/news
+  are the same item.
+*/
+QString HistoryStore::indexKey(const QUrl& url)
+{
+    QString host = url.host();
+    if (host.startsWith("www."))
+        host = host.mid(4);
+    return host + url.path();
+}
+
+void HistoryStore::buildIndex()
+{
+    m_keys.clear();
+    m_ranks.clear();
+    m_index.clear();
+    // position() relies on the rank order
+    qStableSort(m_list.begin(), m_list.end(), itemRankedBefore);
+    for (int i = 0; i < m_list.size();) {
+        QString key = indexKey(m_list.at(i).url());
+        if (m_ranks.contains(key)) {
+            // accessed() merges these, keep the higher ranked one
             m_list.removeAt(i);
-            externalizeSoon();
-            break;
+            continue;
         }
+        m_keys.append(key);
+        m_ranks.insert(key, rank(m_list.at(i)));
+        m_index.add(m_list.at(i).url().toString(), m_list.at(i).title(), key);
+        ++i;
+    }
+}
+
+quint64 HistoryStore::rank(const UrlItem& item)
+{
+    return (quint64(item.refcount()) << 32) | item.lastAccess();
+}
+
+/*!
+  Returns the position of the item with \a key in the list, or -1 if it
+  is not there.
+*/
+int HistoryStore::position(const QString& key) const
+{
+    QHash<QString, quint64>::const_iterator it = m_ranks.constFind(key);
+    if (it == m_ranks.constEnd())
+        return -1;
+    // the first item not ranked above
+    int low = 0;
+    int high = m_list.size();
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (rank(m_list.at(middle)) > *it)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (int i = low; i < m_list.size() && rank(m_list.at(i)) == *it; ++i) {
+        if (m_keys.at(i) == key)
+            return i;
     }
+    // the clock went backwards and broke the order
+    return m_keys.indexOf(key);
+}
+
+void HistoryStore::insertItem(int i, const UrlItem& item, const QString& key)
+{
+    m_list.insert(i, item);
+    m_keys.insert(i, key);
+    m_ranks.insert(key, rank(item));
+    m_index.add(item.url().toString(), item.title(), key);
 }
 
-bool HistoryStore::matchUrls(const QString& url1, const QString& url2)
+void HistoryStore::removeItem(int i)
 {
-    // www.cnn.com == www.cnn.com
-    if (url1 == url2)
-        return true;
-    // www.cnn.com == cnn.com
-    if ((url1.startsWith("www.") && url1.mid(4) == url2) ||
-        (url2.startsWith("www.") && url2.mid(4) == url1))
-        return true;
-    return false;
+    m_index.remove(m_list.at(i).url().toString(), m_list.at(i).title(), m_keys.at(i));
+    m_ranks.remove(m_keys.at(i));
+    m_list.removeAt(i);
+    m_keys.removeAt(i);
 }
 
+/*!
+  Moves the item at \a i from the list to the archive, the thumbnail is
+  dropped.
+*/
+void HistoryStore::archiveItem(int i)
+{
+    const UrlItem& item = m_list.at(i);
+    QString key = m_keys.at(i);
+    HistoryArchive::Item archived;
+    archived.url = item.url().toString();
+    archived.title = item.title();
+    archived.refcount = item.refcount();
+    archived.lastAccess = item.lastAccess();
+
+    m_journal.itemRemoved(item.url());
+    removeItem(i);
+    m_archive.add(key, archived);
+    m_thumbnailsOrphaned = true;
+}
+
+/*!
+  The changes are in the journal already, the whole list is written once
+  in a while so that the journal does not grow long.
+*/
 void HistoryStore::externalizeSoon()
 {
     m_needsPersisting = true;
-    QTimer::singleShot(2000, this, SLOT(externalize()));
+    if (m_journal.records() >= s_maxJournalRecords)
+        externalize();
+    else if (!m_externalizeTimer.isActive())
+        m_externalizeTimer.start();
 }
-
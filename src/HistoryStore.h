@@ -22,19 +22,27 @@
 #define HistoryStore_h_
 
 #include <QObject>
+#include <QFutureWatcher>
 #include <QList>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
 #include <QUrl>
 #include "UrlItem.h"
+#include "HistoryArchive.h"
+#include "UrlStoreJournal.h"
 
 class HistoryStore : public QObject {
     Q_OBJECT
 public:
     static HistoryStore* instance();    
 
-    void accessed(const QUrl& url, const QString& title, QImage* thumbnail);
+    void accessed(const QUrl& url, const QString& title, const QList<QImage>& thumbnailLevels);
     bool contains(const QString& url);
-    QString match(const QString& url);
-    void match(const QString& url, UrlList& matchedItems);
+    QString match(const QString& url, QUrl* matchedUrl = 0);
+    void match(const QString& text, UrlList& matchedItems, int maxItems = 20);
     void remove(const QUrl& url);
     const UrlList& list() { return m_list; }
 
@@ -43,15 +51,46 @@ private:
     ~HistoryStore();
 
     void internalize();
-    bool matchUrls(const QString& url1, const QString& url2);
     void externalizeSoon();
+    void removeOrphanThumbnails();
+
+    static QString indexKey(const QUrl& url);
+    void buildIndex();
+    int position(const QString& key) const;
+    static quint64 rank(const UrlItem& item);
+    void insertItem(int i, const UrlItem& item, const QString& key);
+    void removeItem(int i);
+    void archiveItem(int i);
+    QSet<QString> keysForPrefix(const QString& prefix) const;
+
+    struct RankedKey;
+    RankedKey rankedKey(const QString& key) const;
+    static bool rankedBefore(const RankedKey& key1, const RankedKey& key2);
 
 private Q_SLOTS:
     void externalize();
+    void startupCleanup();
+    void archiveRead();
+    void thumbnailSaved(const QString& path, bool ok);
 
 private:
     UrlList m_list;
+    // index key of each item in m_list, kept in the same order
+    QStringList m_keys;
+    // index key -> rank() of the item in m_list, which is sorted by rank so
+    // the position is found with a binary search. unlike positions, ranks
+    // dont change when other items are inserted or removed
+    QHash<QString, quint64> m_ranks;
+    // hosts and words of the list items, the archive has its own
+    HistoryIndex m_index;
+    HistoryArchive m_archive;
+    QFutureWatcher<HistoryArchive::Contents> m_archiveWatcher;
+    // keys of the new items added before the archive was read
+    QSet<QString> m_visitedBeforeArchive;
+    UrlStoreJournal m_journal;
+    QTimer m_externalizeTimer;
     bool m_needsPersisting;
+    bool m_thumbnailsOrphaned;
 };
 
 #endif
@@ -66,6 +66,8 @@ HomeView::HomeView(HomeWidgetType initialWidget, QGraphicsPixmapItem* bckg, QGra
     connect(m_tabWidget, SIGNAL(closeWidget(void)), SLOT(closeViewSoon()));
     connect(m_bookmarkWidget, SIGNAL(closeWidget(void)), SLOT(closeViewSoon()));
     connect(m_historyWidget, SIGNAL(closeWidget(void)), SLOT(closeViewSoon()));
+    connect(m_bookmarkWidget, SIGNAL(tileCreated(TileItem*)), SLOT(tileCreated(TileItem*)));
+    connect(m_historyWidget, SIGNAL(tileCreated(TileItem*)), SLOT(tileCreated(TileItem*)));
 }
 
 HomeView::~HomeView()
@@ -241,29 +243,22 @@ void HomeView::createViewItems()
 
 void HomeView::createBookmarkContent()
 {
-    const UrlList& list = BookmarkStore::instance()->list();
-    for (int i = 0; i < list.size(); ++i) {
-        ListTileItem* newTileItem = new ListTileItem(m_bookmarkWidget, list.at(i));
-        newTileItem->setEditMode(m_bookmarkWidget->editMode());
-        m_bookmarkWidget->addTile(*newTileItem);
-        connectItem(*newTileItem);
-    }
+    // tiles get created as they scroll into view, see tileCreated()
+    m_bookmarkWidget->setUrlList(BookmarkStore::instance()->list());
     m_bookmarkWidget->layoutTiles();
 }
 
 void HomeView::createHistoryContent()
 {
-    ThumbnailTileItem* newTileItem = 0;
-    const UrlList& list = HistoryStore::instance()->list();
-    for (int i = 0; i < (s_maxHistoryTileNum - 1) && i < list.size(); ++i) {
-        newTileItem = new ThumbnailTileItem(m_historyWidget, list.at(i));
-        newTileItem->setEditMode(m_historyWidget->editMode());
-        m_historyWidget->addTile(*newTileItem);
-        connectItem(*newTileItem);
-    }
+    m_historyWidget->setUrlList(HistoryStore::instance()->list().mid(0, s_maxHistoryTileNum - 1));
     m_historyWidget->layoutTiles();
 }
 
+void HomeView::tileCreated(TileItem* item)
+{
+    connectItem(*item);
+}
+
 void HomeView::createTabSelectContent()
 {
     if (!m_windowList)
@@ -274,14 +269,14 @@ void HomeView::createTabSelectContent()
     for (; i < m_windowList->size(); ++i) {
         WebView* view = m_windowList->at(i);
         bool pageAvailable = !view->url().isEmpty();
-        QImage* thumbnail = 0;
+        QList<QImage> thumbnail;
     
         if (pageAvailable) {
             // get the thumbnail from history store, it'd better be there
             const UrlList& l = HistoryStore::instance()->list();
             for (int i = 0; i < l.size(); ++i) {
                 if (l.at(i).url() == view->url()) {
-                    thumbnail = new QImage(*(l.at(i).thumbnail()));
+                    thumbnail = l.at(i).thumbnailLevels();
                     break;
                 }
             }
@@ -295,13 +290,13 @@ void HomeView::createTabSelectContent()
         connectItem(*tabItem);
     }
     
-    NewWindowTileItem* createTabItem = new NewWindowTileItem(m_tabWidget, UrlItem(QUrl(), "", 0));
+    NewWindowTileItem* createTabItem = new NewWindowTileItem(m_tabWidget, UrlItem(QUrl(), ""));
     m_tabWidget->addTile(*createTabItem);
     connectItem(*createTabItem);
     i++;
     
     for (; i < s_maxWindows; i++) {
-        NewWindowMarkerTileItem* emptyMarkerItem = new NewWindowMarkerTileItem(m_tabWidget, UrlItem(QUrl(), "", 0));
+        NewWindowMarkerTileItem* emptyMarkerItem = new NewWindowMarkerTileItem(m_tabWidget, UrlItem(QUrl(), ""));
         m_tabWidget->addTile(*emptyMarkerItem);
         connectItem(*emptyMarkerItem);
     }
@@ -61,6 +61,7 @@ private Q_SLOTS:
     void tileItemActivated(TileItem*);
     void tileItemClosed(TileItem*);
     void tileItemEditingMode(TileItem*);
+    void tileCreated(TileItem*);
 
 private:
     void moveViews();
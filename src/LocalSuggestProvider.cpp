@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "LocalSuggestProvider.h"
+#include "HistoryStore.h"
+#include "Settings.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSet>
+#include <QDebug>
+
+static const quint8 s_queriesVersion = 1;
+static const int s_maxQueries = 200;
+static const int s_maxSuggestions = 5;
+// longest run of title words suggested as a query
+static const int s_maxTitleWords = 3;
+// a query the user has picked before outranks the title words
+static const uint s_queryWeight = 4;
+
+static QString queriesFileName()
+{
+    return Settings::instance()->privatePath() + "queries.dat";
+}
+
+static QMap<QString, uint> loadQueries()
+{
+    QMap<QString, uint> queries;
+    QFile file(queriesFileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return queries;
+    QDataStream stream(&file);
+    quint8 version;
+    stream >> version;
+    if (version == s_queriesVersion)
+        stream >> queries;
+    if (stream.status() != QDataStream::Ok)
+        queries.clear();
+    return queries;
+}
+
+static QStringList words(const QString& text)
+{
+    QStringList words;
+    QString word;
+    for (int i = 0; i <= text.size(); ++i) {
+        if (i < text.size() && text.at(i).isLetterOrNumber()) {
+            word.append(text.at(i));
+        } else if (!word.isEmpty()) {
+            words.append(word);
+            word.clear();
+        }
+    }
+    return words;
+}
+
+/*!
+  \class LocalSuggestProvider suggests search queries without going to
+  the network.
+
+  The dictionary is made of the queries picked from the popup earlier,
+  kept in queries.dat, and of the word runs of the history titles. It is
+  built when the popup opens, so typing only costs a prefix lookup.
+*/
+LocalSuggestProvider::LocalSuggestProvider(QObject* parent)
+    : SuggestProvider(parent)
+{
+    QMap<QString, uint> queries = loadQueries();
+    QMap<QString, uint>::const_iterator it = queries.constBegin();
+    for (; it != queries.constEnd(); ++it)
+        addPhrase(it.key(), it.value() * s_queryWeight);
+
+    const UrlList& history = HistoryStore::instance()->list();
+    for (int i = 0; i < history.size(); ++i) {
+        QStringList titleWords = words(history.at(i).title());
+        for (int first = 0; first < titleWords.size(); ++first) {
+            // single short words make poor queries
+            if (titleWords.at(first).size() < 3)
+                continue;
+            QString phrase = titleWords.at(first);
+            addPhrase(phrase, history.at(i).refcount());
+            for (int last = first + 1; last < titleWords.size() && last < first + s_maxTitleWords; ++last) {
+                phrase += ' ' + titleWords.at(last);
+                addPhrase(phrase, history.at(i).refcount());
+            }
+        }
+    }
+}
+
+void LocalSuggestProvider::addPhrase(const QString& phrase, uint weight)
+{
+    QString key = phrase.toLower();
+    QHash<QString, int>::const_iterator found = m_phraseIndex.constFind(key);
+    if (found != m_phraseIndex.constEnd()) {
+        m_phrases[*found].weight += weight;
+        return;
+    }
+
+    Phrase newPhrase;
+    newPhrase.text = phrase;
+    newPhrase.weight = weight;
+    int index = m_phrases.size();
+    m_phrases.append(newPhrase);
+    m_phraseIndex.insert(key, index);
+
+    m_prefixes.insert(key, index);
+    for (int i = 1; i < key.size(); ++i) {
+        if (key.at(i - 1) == ' ')
+            m_prefixes.insert(key.mid(i), index);
+    }
+}
+
+void LocalSuggestProvider::start(const QString& text)
+{
+    m_suggestions.clear();
+    QString prefix = text.simplified().toLower();
+    if (prefix.isEmpty())
+        return;
+
+    QSet<int> matched;
+    QMultiMap<QString, int>::const_iterator it = m_prefixes.lowerBound(prefix);
+    for (; it != m_prefixes.constEnd() && it.key().startsWith(prefix); ++it)
+        matched.insert(it.value());
+
+    // pick the heaviest few, the match set is small enough to not sort
+    QList<int> best;
+    QSet<int>::const_iterator match = matched.constBegin();
+    for (; match != matched.constEnd(); ++match) {
+        uint weight = m_phrases.at(*match).weight;
+        int pos = best.size();
+        while (pos > 0 && m_phrases.at(best.at(pos - 1)).weight < weight)
+            --pos;
+        if (pos < s_maxSuggestions) {
+            best.insert(pos, *match);
+            if (best.size() > s_maxSuggestions)
+                best.removeLast();
+        }
+    }
+    for (int i = 0; i < best.size(); ++i)
+        m_suggestions.append(m_phrases.at(best.at(i)).text);
+}
+
+/*!
+  Remembers that \a query was searched for, so that it gets suggested
+  again.
+*/
+void LocalSuggestProvider::addQuery(const QString& query)
+{
+    QString phrase = query.simplified();
+    if (phrase.isEmpty())
+        return;
+
+    QMap<QString, uint> queries = loadQueries();
+    queries[phrase]++;
+    while (queries.size() > s_maxQueries) {
+        // the new query would always be the lightest one
+        QMap<QString, uint>::iterator lightest = queries.end();
+        for (QMap<QString, uint>::iterator it = queries.begin(); it != queries.end(); ++it) {
+            if (it.key() != phrase && (lightest == queries.end() || it.value() < lightest.value()))
+                lightest = it;
+        }
+        queries.erase(lightest);
+    }
+
+    QString fileName = queriesFileName();
+    QFile file(fileName + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "LocalSuggestProvider: cannot write" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_queriesVersion << queries;
+    file.close();
+    if (stream.status() != QDataStream::Ok) {
+        file.remove();
+        return;
+    }
+    QFile::remove(fileName);
+    file.rename(fileName);
+}
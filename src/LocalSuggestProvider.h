@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef LocalSuggestProvider_h_
+#define LocalSuggestProvider_h_
+
+#include "SuggestProvider.h"
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+
+class LocalSuggestProvider : public SuggestProvider {
+    Q_OBJECT
+public:
+    LocalSuggestProvider(QObject* parent = 0);
+
+    void start(const QString& text);
+    void stop() {}
+
+    static void addQuery(const QString& query);
+
+private:
+    void addPhrase(const QString& phrase, uint weight);
+
+    struct Phrase {
+        QString text;
+        uint weight;
+    };
+    QList<Phrase> m_phrases;
+    // lower cased phrase -> index in m_phrases
+    QHash<QString, int> m_phraseIndex;
+    // lower cased phrase, and its tails starting at a word -> index in
+    // m_phrases, sorted for prefix lookups
+    QMultiMap<QString, int> m_prefixes;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "NetworkSuggestProvider.h"
+#include "YberApplication.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QUrl>
+
+// dont send a request for every key press
+static const int s_requestDelay = 300;
+
+static ushort hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return 0;
+}
+
+/*!
+  \class NetworkSuggestProvider fetches search suggestions from the
+  google suggest service.
+
+  The reply, ["text", ["suggestion", ...], ...], is parsed as it arrives
+  and only the strings of the second element are kept.
+*/
+NetworkSuggestProvider::NetworkSuggestProvider(QObject* parent)
+    : SuggestProvider(parent)
+    , m_reply(0)
+{
+    m_requestTimer.setSingleShot(true);
+    m_requestTimer.setInterval(s_requestDelay);
+    connect(&m_requestTimer, SIGNAL(timeout()), this, SLOT(sendRequest()));
+    resetParser();
+}
+
+NetworkSuggestProvider::~NetworkSuggestProvider()
+{
+    stop();
+}
+
+void NetworkSuggestProvider::start(const QString& text)
+{
+    stop();
+    m_text = text.simplified();
+    if (m_text.isEmpty()) {
+        m_suggestions.clear();
+        return;
+    }
+    m_requestTimer.start();
+}
+
+void NetworkSuggestProvider::stop()
+{
+    m_requestTimer.stop();
+    if (!m_reply)
+        return;
+    m_reply->disconnect(this);
+    m_reply->abort();
+    m_reply->deleteLater();
+    m_reply = 0;
+}
+
+void NetworkSuggestProvider::sendRequest()
+{
+    QUrl url("http://suggestqueries.google.com/complete/search");
+    url.addQueryItem("output", "firefox");
+    url.addQueryItem("oe", "utf8");
+    url.addQueryItem("q", m_text);
+
+    resetParser();
+    m_reply = YberApplication::instance()->networkAccessManager()->get(QNetworkRequest(url));
+    connect(m_reply, SIGNAL(readyRead()), this, SLOT(readSuggestions()));
+    connect(m_reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+}
+
+void NetworkSuggestProvider::readSuggestions()
+{
+    parse(m_reply->readAll());
+}
+
+void NetworkSuggestProvider::replyFinished()
+{
+    bool ok = m_reply->error() == QNetworkReply::NoError;
+    if (ok)
+        parse(m_reply->readAll());
+    m_reply->deleteLater();
+    m_reply = 0;
+    // the suggestions of the previous text would not match this one
+    m_suggestions = ok ? m_received : QStringList();
+    emit suggestionsAvailable();
+}
+
+void NetworkSuggestProvider::resetParser()
+{
+    m_received.clear();
+    m_depth = 0;
+    m_element = 0;
+    m_inString = false;
+    m_escape = false;
+    m_unicodeDigits = 0;
+    m_unicode = 0;
+    m_string.clear();
+}
+
+void NetworkSuggestProvider::parse(const QByteArray& data)
+{
+    // the strings are collected as utf8 and decoded when complete, so
+    // that multibyte characters can be split between the chunks
+    for (int i = 0; i < data.size(); ++i) {
+        char c = data.at(i);
+        if (m_inString) {
+            if (m_unicodeDigits) {
+                m_unicode = (m_unicode << 4) | hexValue(c);
+                if (!--m_unicodeDigits)
+                    m_string += QString(QChar(m_unicode)).toUtf8();
+            } else if (m_escape) {
+                m_escape = false;
+                switch (c) {
+                case 'n': m_string += '\n'; break;
+                case 't': m_string += '\t'; break;
+                case 'r': m_string += '\r'; break;
+                case 'b': m_string += '\b'; break;
+                case 'f': m_string += '\f'; break;
+                case 'u': m_unicodeDigits = 4; m_unicode = 0; break;
+                default: m_string += c; break;
+                }
+            } else if (c == '\\')
+                m_escape = true;
+            else if (c == '"') {
+                m_inString = false;
+                if (m_depth == 2 && m_element == 1)
+                    m_received.append(QString::fromUtf8(m_string));
+            } else
+                m_string += c;
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            m_string.clear();
+            break;
+        case '[':
+        case '{':
+            ++m_depth;
+            break;
+        case ']':
+        case '}':
+            --m_depth;
+            break;
+        case ',':
+            if (m_depth == 1)
+                ++m_element;
+            break;
+        }
+    }
+}
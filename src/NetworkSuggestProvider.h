@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef NetworkSuggestProvider_h_
+#define NetworkSuggestProvider_h_
+
+#include "SuggestProvider.h"
+
+#include <QByteArray>
+#include <QTimer>
+
+class QNetworkReply;
+
+class NetworkSuggestProvider : public SuggestProvider {
+    Q_OBJECT
+public:
+    NetworkSuggestProvider(QObject* parent = 0);
+    ~NetworkSuggestProvider();
+
+    void start(const QString& text);
+    void stop();
+
+private Q_SLOTS:
+    void sendRequest();
+    void readSuggestions();
+    void replyFinished();
+
+private:
+    void resetParser();
+    void parse(const QByteArray& data);
+
+    QString m_text;
+    QTimer m_requestTimer;
+    QNetworkReply* m_reply;
+    QStringList m_received;
+
+    // state of the json parser, kept between the chunks of the reply
+    int m_depth;
+    int m_element;
+    bool m_inString;
+    bool m_escape;
+    int m_unicodeDigits;
+    ushort m_unicode;
+    QByteArray m_string;
+};
+
+#endif
@@ -84,6 +84,40 @@ QPointF PannableViewport::position() const
     return m_pannedWidget->pos() - m_overShootDelta;
 }
 
+/*!
+  Returns the speed of the kinetic scroll in pixels per second,
+  in the direction the panned widget moves.
+*/
+QPointF PannableViewport::velocity() const
+{
+    return YberHack_Qt::QAbstractKineticScroller::velocity() * scrollsPerSecond();
+}
+
+/*!
+  Returns how much further the panned widget moves before the kinetic
+  scroll comes to a halt. The velocity is multiplied by the deceleration
+  factor on every scroll, so the distance is a geometric series.
+*/
+QPointF PannableViewport::flingDistance() const
+{
+    qreal deceleration = decelerationFactor();
+    if (!isAutoScrolling() || deceleration >= 1)
+        return QPointF();
+
+    QPointF distance = YberHack_Qt::QAbstractKineticScroller::velocity() / (1 - deceleration);
+    // the scroll stops at the edges
+    QPointF pos = position();
+    QPoint maxPos = maximumScrollPosition();
+    distance.setX(qBound(-maxPos.x() - pos.x(), distance.x(), -pos.x()));
+    distance.setY(qBound(-maxPos.y() - pos.y(), distance.y(), -pos.y()));
+    return distance;
+}
+
+bool PannableViewport::isAutoScrolling() const
+{
+    return state() == YberHack_Qt::QAbstractKineticScroller::AutoScrolling;
+}
+
 void PannableViewport::setRange(const QRectF& )
 {
 }
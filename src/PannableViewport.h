@@ -32,6 +32,10 @@ public:
         : MPannableViewport(parent)
         {
         }
+
+    QPointF velocity() const { return QPointF(); }
+    QPointF flingDistance() const { return QPointF(); }
+    bool isAutoScrolling() const { return false; }
 };
 
 #else
@@ -56,6 +60,9 @@ public:
 
     void setPosition(const QPointF& pos);
     QPointF position() const;
+    QPointF velocity() const;
+    QPointF flingDistance() const;
+    bool isAutoScrolling() const;
 
     void setRange(const QRectF&);
     void setAutoRange(bool) { }
@@ -24,112 +24,25 @@
 #include "TileContainerWidget.h"
 #include "PannableViewport.h"
 #include "WebView.h"
+#include "LocalSuggestProvider.h"
+#include "NetworkSuggestProvider.h"
+#include "Settings.h"
 
 #include <QPen>
-#include <QTimer>
-#include <qwebpage.h>
-#include <qwebframe.h>
-#if 0
-#include <QtScript/QScriptEngine>
-#include <QtScript/QScriptValueIterator>
-#endif
-
-class Suggest : public QObject {
-    Q_OBJECT
-public:
-    Suggest();
-    void start(const QString& text);
-    void stop();
-    QList<QString>* suggestions() { return &m_suggestions; }
-
-Q_SIGNALS:
-    void suggestionsAvailable();
-
-private Q_SLOTS:
-    void loadFinished(bool success);
-    
-private:
-    bool m_loading;
-#if !USE_WEBKIT2
-    QGraphicsWebView m_view;
-#endif
-    QList<QString> m_suggestions;
-};
-
-Suggest::Suggest()
-    : m_loading(false)
-{
-#if !USE_WEBKIT2
-    connect(&m_view, SIGNAL(loadFinished(bool)), this, SLOT(loadFinished(bool)));    
-#endif
-}
-
-void Suggest::start(const QString& text)
-{
-#if USE_WEBKIT2
-    Q_UNUSED(text)
-#else
-    if (m_loading)
-        m_view.triggerPageAction(QWebPage::Stop);
-    m_loading = true;
-    m_view.load(QUrl("http://suggestqueries.google.com/complete/search?qu=" + text));
-#endif
-}
-
-void Suggest::stop() 
-{
-#if !USE_WEBKIT2
-    if (!m_loading)
-        return;
-
-    m_view.triggerPageAction(QWebPage::Stop);
-#endif
-}
-
-void Suggest::loadFinished(bool success)
-{
-    m_loading = false;
-    m_suggestions.clear();
-
-    if (!success)
-        return;
-#if 0
-    QString json = m_view.page()->mainFrame()->toPlainText();
-    int start = json.indexOf("(");
-    if (start != -1) {
-        json = json.mid(start);
-
-        QScriptEngine engine;
-        QScriptValue sc = engine.evaluate(json);
-
-        if (sc.property(1).isArray()) {
-            QScriptValueIterator it(sc.property(1));
-            while (it.hasNext()) {
-                it.next();
-                if (it.value().isArray()) {
-                    // only the first value is needed
-                    QScriptValueIterator itt(it.value());
-                    itt.next();
-                    m_suggestions.append(itt.value().toString());
-                }
-            }
-        }
-    }
-    emit suggestionsAvailable();
-#endif
-}
 
 PopupView::PopupView(QGraphicsItem* parent, Qt::WindowFlags wFlags)
     : TileSelectionViewBase(TileSelectionViewBase::UrlPopup, 0, parent, wFlags)
-    , m_suggest(new Suggest())
-    , m_suggestTimer(new QTimer(this))
+    , m_suggest(0)
     , m_bckg(new QGraphicsRectItem(rect(), this))
     , m_popupWidget(new PopupWidget(this))
     , m_pannableContainer(new PannableViewport(this))
 {
     m_pannableContainer->setWidget(m_popupWidget);
     connect(m_popupWidget, SIGNAL(closeWidget(void)), this, SLOT(closeViewSoon()));
-    connect(m_suggestTimer, SIGNAL(timeout()), this, SLOT(startSuggest()));
+    if (Settings::instance()->networkSuggestEnabled())
+        m_suggest = new NetworkSuggestProvider(this);
+    else
+        m_suggest = new LocalSuggestProvider(this);
     connect(m_suggest, SIGNAL(suggestionsAvailable()), this, SLOT(populateSuggestion()));
     m_bckg->setPen(Qt::NoPen);
     m_bckg->setBrush(QColor(60, 60, 60, 220));
@@ -150,19 +63,9 @@ void PopupView::resizeEvent(QGraphicsSceneResizeEvent* event)
 
 void PopupView::setFilterText(const QString& text)
 {
-#ifdef QTSCRIPT_FIX_AVAILABLE
-    m_suggestTimer->start(500);
-    m_suggest->stop();
-#endif
-
     m_filterText = text;
-    updateContent();
-}
-
-void PopupView::startSuggest()
-{
-    m_suggestTimer->stop();
     m_suggest->start(m_filterText);
+    updateContent();
 }
 
 void PopupView::populateSuggestion()
@@ -175,9 +78,15 @@ void PopupView::tileItemActivated(TileItem* item)
     TileSelectionViewBase::tileItemActivated(item);
 
     QUrl url = item->urlItem()->url();
+    // the "no match" row
+    if (url.isEmpty())
+        return;
     // FIXME this is ugly but ok as temp
-    if (url.toString() == "google suggest")
-        url = "http://www.google.com/search?q=" + item->urlItem()->title();      
+    if (url.toString() == "google suggest") {
+        url = QUrl("http://www.google.com/search");
+        url.addQueryItem("q", item->urlItem()->title());
+        LocalSuggestProvider::addQuery(item->urlItem()->title());
+    }
     emit pageSelected(url);
 }
 
@@ -203,34 +112,42 @@ void PopupView::resetContainerSize()
 
 void PopupView::destroyViewItems()
 {
-    m_popupWidget->removeAll();
+    // createViewItems() reuses them
+    m_popupWidget->recycleTiles();
 }
 
 void PopupView::createViewItems()
 {
     UrlList matchedItems;
     HistoryStore::instance()->match(m_filterText, matchedItems);
-    QList<QString>* suggestList = m_suggest->suggestions();
+    const QStringList& suggestList = m_suggest->suggestions();
 
-    // FIXME let the urlitem leak for now
+    UrlList rows;
     // add suggest items to the top
-    for (int i = 0; i < suggestList->size() && i < (matchedItems.isEmpty() ? 5 : 2) ; ++i) {
-        ListTileItem* suggestItem = new ListTileItem(m_popupWidget, *(new UrlItem(QUrl("google suggest"), suggestList->at(i), 0)));
-        m_popupWidget->addTile(*suggestItem);
-        connectItem(*suggestItem);
-    }
-
-    if (matchedItems.isEmpty()) {
-        if (suggestList->isEmpty())
-            m_popupWidget->addTile(*(new ListTileItem(m_popupWidget, *(new UrlItem(QUrl(), "no match", 0)))));
-    } else {
-        for (int i = 0; i < matchedItems.size(); ++i) {
-            ListTileItem* newTileItem = new ListTileItem(m_popupWidget, matchedItems.at(i));
-            m_popupWidget->addTile(*newTileItem);
-            connectItem(*newTileItem);
+    for (int i = 0; i < suggestList.size() && i < (matchedItems.isEmpty() ? 5 : 2) ; ++i)
+        rows.append(UrlItem(QUrl("google suggest"), suggestList.at(i)));
+    rows += matchedItems;
+    if (rows.isEmpty())
+        rows.append(UrlItem(QUrl(), "no match"));
+
+    // rows still in the result keep their tile as it was laid out and painted,
+    // the layout only moves it. the other rows get the tiles left over
+    TileList tiles;
+    for (int i = 0; i < rows.size(); ++i)
+        tiles.append(m_popupWidget->takeRecycledTile(rows.at(i)));
+    for (int i = 0; i < rows.size(); ++i) {
+        TileItem* tile = tiles.at(i);
+        if (!tile) {
+            tile = m_popupWidget->takeRecycledTile();
+            if (tile)
+                tile->setUrlItem(rows.at(i));
+            else {
+                tile = new ListTileItem(m_popupWidget, rows.at(i));
+                connectItem(*tile);
+            }
         }
+        m_popupWidget->addTile(*tile);
     }
+    m_popupWidget->hideRecycledTiles();
     m_popupWidget->layoutTiles();
 }
-
-#include "PopupView.moc"
@@ -26,8 +26,7 @@
 class PannableViewport;
 class PopupWidget;
 class TileItem;
-class Suggest;
-class QTimer;
+class SuggestProvider;
 class QGraphicsRectItem;
 
 class PopupView : public TileSelectionViewBase {
@@ -47,7 +46,6 @@ private Q_SLOTS:
     void tileItemActivated(TileItem*);
     void tileItemClosed(TileItem*);
     void tileItemEditingMode(TileItem*);
-    void startSuggest();
     void populateSuggestion();
 
 private:
@@ -57,8 +55,7 @@ private:
     void destroyViewItems();
 
 private:
-    Suggest* m_suggest;
-    QTimer* m_suggestTimer;
+    SuggestProvider* m_suggest;
     QGraphicsRectItem* m_bckg;
     PopupWidget* m_popupWidget;
     PannableViewport* m_pannableContainer;
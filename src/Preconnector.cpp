@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "Preconnector.h"
+#include "YberApplication.h"
+
+#include <QHostInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+// typing usually goes through a few candidates, wait for it to settle
+static const int s_startDelay = 200;
+// roughly how long servers keep an idle connection open
+static const int s_connectionLifetime = 15000;
+
+/*!
+  \class Preconnector resolves the host and opens a connection to the
+  site the user is most likely typing, so that most of the network setup
+  is done by the time the url is entered.
+
+  Qt 4 has no api for opening a bare connection, a HEAD request to the
+  site root is sent through the shared network access manager instead,
+  which leaves a keep-alive connection in its pool. The request must not
+  touch the cookies, before Qt 4.7 it cannot be told so and only the host
+  is resolved.
+*/
+Preconnector* Preconnector::instance()
+{
+    static Preconnector* preconnector = 0;
+    if (!preconnector)
+        preconnector = new Preconnector();
+    return preconnector;
+}
+
+Preconnector::Preconnector()
+    : m_lookupId(-1)
+    , m_reply(0)
+{
+    m_startTimer.setSingleShot(true);
+    m_startTimer.setInterval(s_startDelay);
+    connect(&m_startTimer, SIGNAL(timeout()), this, SLOT(startLookup()));
+}
+
+/*!
+  Starts connecting to the host of \a url, cancelling the connection to
+  any previous candidate host.
+*/
+void Preconnector::preconnect(const QUrl& url)
+{
+    if (url.host() == m_url.host())
+        return;
+    cancel();
+    if (url.host().isEmpty() || (url.scheme() != "http" && url.scheme() != "https"))
+        return;
+    m_url = url;
+    m_startTimer.start();
+}
+
+void Preconnector::cancel()
+{
+    m_startTimer.stop();
+    m_url = QUrl();
+    if (m_lookupId != -1) {
+        QHostInfo::abortHostLookup(m_lookupId);
+        m_lookupId = -1;
+    }
+    if (m_reply) {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply->deleteLater();
+        m_reply = 0;
+    }
+}
+
+void Preconnector::startLookup()
+{
+    QHash<QString, QTime>::const_iterator it = m_connected.constFind(m_url.host());
+    if (it != m_connected.constEnd() && it->elapsed() < s_connectionLifetime)
+        return;
+    m_lookupId = QHostInfo::lookupHost(m_url.host(), this, SLOT(hostFound(const QHostInfo&)));
+}
+
+void Preconnector::hostFound(const QHostInfo& hostInfo)
+{
+    if (hostInfo.lookupId() != m_lookupId)
+        return;
+    m_lookupId = -1;
+    if (hostInfo.error() != QHostInfo::NoError)
+        return;
+#if !USE_WEBKIT2 && QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+    // the pages only share connections through the manager with webkit1
+    QUrl root;
+    root.setScheme(m_url.scheme());
+    root.setHost(m_url.host());
+    root.setPort(m_url.port());
+    root.setPath("/");
+    QNetworkRequest request(root);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    // the user did not ask for the site yet, no cookies sent or stored
+    request.setAttribute(QNetworkRequest::CookieLoadControlAttribute, QNetworkRequest::Manual);
+    request.setAttribute(QNetworkRequest::CookieSaveControlAttribute, QNetworkRequest::Manual);
+    m_reply = YberApplication::instance()->networkAccessManager()->head(request);
+    connect(m_reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+#endif
+}
+
+void Preconnector::replyFinished()
+{
+    if (m_reply->error() == QNetworkReply::NoError)
+        m_connected[m_url.host()].start();
+    m_reply->deleteLater();
+    m_reply = 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef Preconnector_h_
+#define Preconnector_h_
+
+#include <QHash>
+#include <QObject>
+#include <QTime>
+#include <QTimer>
+#include <QUrl>
+
+class QHostInfo;
+class QNetworkReply;
+
+class Preconnector : public QObject {
+    Q_OBJECT
+public:
+    static Preconnector* instance();
+
+    void preconnect(const QUrl& url);
+    void cancel();
+
+private:
+    Preconnector();
+
+private Q_SLOTS:
+    void startLookup();
+    void hostFound(const QHostInfo& hostInfo);
+    void replyFinished();
+
+private:
+    QUrl m_url;
+    int m_lookupId;
+    QNetworkReply* m_reply;
+    QTimer m_startTimer;
+    // host -> when its connection was last warmed up
+    QHash<QString, QTime> m_connected;
+};
+
+#endif
@@ -38,6 +38,10 @@ public:
     void enableTileVisualization(bool enable) { m_tileVisualizationEnabled = enable; }
     bool tileVisualizationEnabled() const { return m_tileVisualizationEnabled; }
 
+    // tile statistics are appended to the given file every second
+    void setTileStatsLog(const QString& path) { m_tileStatsLog = path; }
+    QString tileStatsLog() const { return m_tileStatsLog; }
+
     void setUseGL(bool use) { m_useGL = use; }
     bool useGL() const { return m_useGL; }
 
@@ -47,6 +51,10 @@ public:
     void enableAutoComplete(bool enable) { m_autoCompleteEnabled = enable; }
     bool autoCompleteEnabled() const { return m_autoCompleteEnabled; }
 
+    // search suggestions from the network instead of the local dictionary
+    void enableNetworkSuggest(bool enable) { m_networkSuggestEnabled = enable; }
+    bool networkSuggestEnabled() const { return m_networkSuggestEnabled; }
+
     void enableTileCache(bool enable) { m_tilingEnabled = enable; }
     bool tileCacheEnabled() const { return m_tilingEnabled; }
 
@@ -57,6 +65,12 @@ public:
     bool isFullScreen() const { return m_isFullScreen; }
 
     QString cookieFilePath() const { return privatePath() + "cookies.dat"; }
+    QString diskCachePath() const { return privatePath() + "cache/"; }
+
+    // scroll benchmark mode, results are written to the given file
+    void setBenchmarkOutput(const QString& path) { m_benchmarkOutput = path; }
+    QString benchmarkOutput() const { return m_benchmarkOutput; }
+    bool benchmarkEnabled() const { return !m_benchmarkOutput.isEmpty(); }
 
 private:
     Settings() {
@@ -65,6 +79,7 @@ private:
         m_useGL = false;
         m_showFPS = false;
         m_autoCompleteEnabled = true;
+        m_networkSuggestEnabled = false;
         m_tilingEnabled = true;
 #if defined(Q_WS_MAEMO_5) || defined(Q_OS_SYMBIAN) || USE_MEEGOTOUCH
         m_isFullScreen = true;
@@ -78,9 +93,12 @@ private:
     bool m_useGL;
     bool m_showFPS;
     bool m_autoCompleteEnabled;
+    bool m_networkSuggestEnabled;
     bool m_tilingEnabled;
     QString m_privatePath;
     bool m_isFullScreen;
+    QString m_benchmarkOutput;
+    QString m_tileStatsLog;
 };
 
 #endif
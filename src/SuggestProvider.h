@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef SuggestProvider_h_
+#define SuggestProvider_h_
+
+#include <QObject>
+#include <QStringList>
+
+/*! \class SuggestProvider source of search suggestions for the url popup.
+
+  Providers that can answer right away have suggestions() ready when
+  start() returns, others emit suggestionsAvailable() once they are done.
+*/
+class SuggestProvider : public QObject {
+    Q_OBJECT
+public:
+    SuggestProvider(QObject* parent = 0) : QObject(parent) {}
+
+    virtual void start(const QString& text) = 0;
+    virtual void stop() = 0;
+    const QStringList& suggestions() const { return m_suggestions; }
+
+Q_SIGNALS:
+    void suggestionsAvailable();
+
+protected:
+    QStringList m_suggestions;
+};
+
+#endif
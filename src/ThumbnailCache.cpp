@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "ThumbnailCache.h"
+#include "Helpers.h"
+#include "ThumbnailWriter.h"
+#include "Settings.h"
+
+#include <QFile>
+#include <QDebug>
+
+// decoded thumbnails kept around, in kilobytes
+static const int s_cacheBudget = 8 * 1024;
+static const quint32 s_rawMagic = 0x59425431; // "YBT1"
+// raw thumbnails are 16 bit, half the size of the captured ones and what the n900 paints fastest
+static const QImage::Format s_rawFormat = QImage::Format_RGB16;
+
+struct RawHeader {
+    quint32 magic;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+};
+
+/*!
+  \class ThumbnailCache loads thumbnails when they are first painted.
+
+  Next to each png the ThumbnailWriter leaves an uncompressed copy,
+  reading that is a memory map and a copy instead of a png decode. The
+  decoded thumbnails and their downscaled levels are kept in a cost
+  limited LRU cache.
+*/
+ThumbnailCache* ThumbnailCache::instance()
+{
+    static ThumbnailCache* cache = 0;
+    if (!cache)
+        cache = new ThumbnailCache();
+    return cache;
+}
+
+ThumbnailCache::ThumbnailCache()
+    : m_cache(s_cacheBudget)
+{
+}
+
+/*!
+  Returns the levels of the thumbnail stored as \a path in the private
+  path, or an empty list if there is no such thumbnail.
+*/
+QList<QImage> ThumbnailCache::thumbnail(const QString& path)
+{
+    if (path.isEmpty() || m_missing.contains(path))
+        return QList<QImage>();
+    if (QList<QImage>* cached = m_cache.object(path))
+        return *cached;
+
+    QString fileName = Settings::instance()->privatePath() + path;
+    QImage image = readRaw(rawPath(fileName));
+    if (image.isNull()) {
+        // written by an older version, or the raw copy got lost
+        image = QImage(fileName);
+        if (image.isNull()) {
+            // the writer did not get to it before exit, or it got removed
+            m_missing.insert(path);
+            return QList<QImage>();
+        }
+        ThumbnailWriter::instance()->saveRaw(path, image);
+    }
+    QList<QImage> levels = thumbnailLevels(image);
+    insert(path, levels);
+    return levels;
+}
+
+void ThumbnailCache::insert(const QString& path, const QList<QImage>& thumbnailLevels)
+{
+    int cost = 0;
+    for (int i = 0; i < thumbnailLevels.size(); ++i)
+        cost += thumbnailLevels.at(i).byteCount();
+    m_missing.remove(path);
+    m_cache.insert(path, new QList<QImage>(thumbnailLevels), qMax(1, cost / 1024));
+}
+
+/*!
+  Drops the decoded thumbnails, they load from the raw copies again when
+  needed.
+*/
+void ThumbnailCache::releaseMemory()
+{
+    m_cache.clear();
+}
+
+QString ThumbnailCache::rawPath(const QString& path)
+{
+    QString raw(path);
+    if (raw.endsWith(".png"))
+        raw.chop(4);
+    return raw + ".raw";
+}
+
+/*!
+  Writes \a thumbnail uncompressed, safe to call from any thread.
+*/
+bool ThumbnailCache::writeRaw(const QString& fileName, const QImage& thumbnail)
+{
+    QImage image = thumbnail.format() == s_rawFormat ? thumbnail : thumbnail.convertToFormat(s_rawFormat);
+    RawHeader header;
+    header.magic = s_rawMagic;
+    header.width = image.width();
+    header.height = image.height();
+    header.bytesPerLine = image.bytesPerLine();
+
+    QString tmpFileName = fileName + ".tmp";
+    QFile file(tmpFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header)
+        && file.write(reinterpret_cast<const char*>(image.bits()), image.byteCount()) == image.byteCount();
+    file.close();
+    if (!ok || !QFile::rename(tmpFileName, fileName)) {
+        QFile::remove(tmpFileName);
+        return false;
+    }
+    return true;
+}
+
+QImage ThumbnailCache::readRaw(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(RawHeader)))
+        return QImage();
+    uchar* data = file.map(0, file.size());
+    if (!data)
+        return QImage();
+
+    QImage image;
+    const RawHeader* header = reinterpret_cast<const RawHeader*>(data);
+    if (header->magic == s_rawMagic
+        && file.size() >= qint64(sizeof(RawHeader) + header->bytesPerLine * header->height)) {
+        // the mapping goes away with the file, the cached image owns its pixels
+        image = QImage(data + sizeof(RawHeader), header->width, header->height, header->bytesPerLine, s_rawFormat).copy();
+    }
+    file.unmap(data);
+    return image;
+}
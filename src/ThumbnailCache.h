@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef ThumbnailCache_h_
+#define ThumbnailCache_h_
+
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+class ThumbnailCache {
+public:
+    static ThumbnailCache* instance();
+
+    QList<QImage> thumbnail(const QString& path);
+    void insert(const QString& path, const QList<QImage>& thumbnailLevels);
+    void releaseMemory();
+
+    static QString rawPath(const QString& path);
+    static bool writeRaw(const QString& fileName, const QImage& thumbnail);
+    static QImage readRaw(const QString& fileName);
+
+private:
+    ThumbnailCache();
+
+    // cost is in kilobytes
+    QCache<QString, QList<QImage> > m_cache;
+    // paths that failed to load, not looked up from the disk again
+    QSet<QString> m_missing;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "ThumbnailWriter.h"
+#include "Settings.h"
+#include "ThumbnailCache.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QDebug>
+
+// the ui thread never waits for the writer, a full queue turns saves down
+static const int s_maxQueuedThumbnails = 16;
+
+/*!
+  \class ThumbnailWriter encodes and writes thumbnails in a thread of its own.
+
+  Thumbnail files are named after their content, a thumbnail that is
+  already on disk is not written again. save() returns the name right
+  away and the file appears once the writer gets to it,
+  thumbnailSaved() tells when it did. The raw copy ThumbnailCache loads
+  from is written along with the png. The queued thumbnails are written
+  before the application quits.
+*/
+ThumbnailWriter* ThumbnailWriter::instance()
+{
+    static ThumbnailWriter* writer = 0;
+    if (!writer) {
+        writer = new ThumbnailWriter();
+        writer->start(QThread::LowPriority);
+    }
+    return writer;
+}
+
+ThumbnailWriter::ThumbnailWriter()
+    : m_privatePath(Settings::instance()->privatePath())
+    , m_quit(false)
+{
+    // the writer is never deleted
+    connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(finish()));
+}
+
+void ThumbnailWriter::finish()
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_jobQueued.wakeOne();
+    m_mutex.unlock();
+    wait();
+}
+
+/*!
+  Queues \a thumbnail for writing and returns its file name relative to
+  the private path. Returns an empty string if the queue is full, the
+  caller is expected to try again later.
+*/
+QString ThumbnailWriter::save(const QImage& thumbnail)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(reinterpret_cast<const char*>(thumbnail.bits()), thumbnail.byteCount());
+    hash.addData(QByteArray::number(thumbnail.width()) + 'x' + QByteArray::number(thumbnail.height()));
+    QString path = hash.result().toHex() + ".png";
+    return enqueue(path, thumbnail, false) ? path : QString();
+}
+
+/*!
+  Queues the raw copy of an existing png thumbnail \a path for writing.
+*/
+void ThumbnailWriter::saveRaw(const QString& path, const QImage& thumbnail)
+{
+    enqueue(path, thumbnail, true);
+}
+
+bool ThumbnailWriter::enqueue(const QString& path, const QImage& thumbnail, bool rawOnly)
+{
+    QMutexLocker locker(&m_mutex);
+    if (path == m_writing)
+        return true;
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue.at(i).path == path)
+            return true;
+    }
+    if (m_queue.size() >= s_maxQueuedThumbnails)
+        return false;
+
+    Job job;
+    job.path = path;
+    // shallow copy, the image is not modified on either side
+    job.image = thumbnail;
+    job.rawOnly = rawOnly;
+    m_queue.enqueue(job);
+    m_jobQueued.wakeOne();
+    return true;
+}
+
+/*!
+  Blocks until the queued thumbnails are on disk, meant for shutdown only.
+*/
+void ThumbnailWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_queue.isEmpty() || !m_writing.isEmpty())
+        m_jobDone.wait(&m_mutex);
+}
+
+void ThumbnailWriter::run()
+{
+    forever {
+        m_mutex.lock();
+        while (m_queue.isEmpty() && !m_quit)
+            m_jobQueued.wait(&m_mutex);
+        // queued thumbnails are written before quitting
+        if (m_queue.isEmpty()) {
+            m_mutex.unlock();
+            return;
+        }
+        Job job = m_queue.dequeue();
+        m_writing = job.path;
+        m_mutex.unlock();
+
+        QString fileName = m_privatePath + job.path;
+        bool ok = job.rawOnly || QFile::exists(fileName);
+        if (!ok) {
+            // a half written file would pass for the thumbnail next time
+            QString tmpFileName = fileName + ".tmp";
+            ok = job.image.save(tmpFileName, "PNG") && QFile::rename(tmpFileName, fileName);
+            if (!ok) {
+                qWarning() << "ThumbnailWriter: failed to write" << fileName;
+                QFile::remove(tmpFileName);
+            }
+        }
+        // the raw copy is only a cache, the png is enough if it fails
+        QString rawFileName = ThumbnailCache::rawPath(fileName);
+        if (ok && !QFile::exists(rawFileName))
+            ThumbnailCache::writeRaw(rawFileName, job.image);
+        if (!job.rawOnly)
+            emit thumbnailSaved(job.path, ok);
+
+        m_mutex.lock();
+        m_writing.clear();
+        m_jobDone.wakeAll();
+        m_mutex.unlock();
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef ThumbnailWriter_h_
+#define ThumbnailWriter_h_
+
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+class ThumbnailWriter : public QThread {
+    Q_OBJECT
+public:
+    static ThumbnailWriter* instance();
+
+    QString save(const QImage& thumbnail);
+    void saveRaw(const QString& path, const QImage& thumbnail);
+    void flush();
+
+Q_SIGNALS:
+    void thumbnailSaved(const QString& path, bool ok);
+
+protected:
+    void run();
+
+private Q_SLOTS:
+    void finish();
+
+private:
+    ThumbnailWriter();
+
+    struct Job {
+        QString path;
+        QImage image;
+        bool rawOnly;
+    };
+
+    bool enqueue(const QString& path, const QImage& thumbnail, bool rawOnly);
+
+    QString m_privatePath;
+    QMutex m_mutex;
+    QWaitCondition m_jobQueued;
+    QWaitCondition m_jobDone;
+    QQueue<Job> m_queue;
+    // job being written, not in the queue anymore
+    QString m_writing;
+    bool m_quit;
+};
+
+#endif
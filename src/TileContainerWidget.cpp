@@ -31,7 +31,6 @@
 #include <QGraphicsSimpleTextItem>
 #include <QPainter>
 #include <QPen>
-#include <QFontMetrics>
 #include <QDebug>
 
 #ifdef Q_OS_SYMBIAN
@@ -48,6 +47,8 @@ const int s_bookmarksTileHeight = 70;
 const int s_searchItemTileHeight = 60;
 #endif
 const int s_containerYBottomMargin = 10;
+// tiles are created this far outside of the visible area in virtualized mode
+const int s_tilePrefetchMargin = 100;
 
 TileBaseWidget::TileBaseWidget(const QString& title, QGraphicsItem* parent, Qt::WindowFlags wFlags)
     : QGraphicsWidget(parent, wFlags)
@@ -55,6 +56,10 @@ TileBaseWidget::TileBaseWidget(const QString& title, QGraphicsItem* parent, Qt::
     , m_slideAnimationGroup(0)
     , m_editMode(false)
     , m_moved(false)
+    , m_virtualized(false)
+    , m_firstVisible(0)
+    , m_lastVisible(-1)
+    , m_gridColumns(1)
 {
 }
 
@@ -62,6 +67,7 @@ TileBaseWidget::~TileBaseWidget()
 {
     delete m_slideAnimationGroup;
     removeAll();
+    qDeleteAll(m_recycledTiles);
 }
 
 void TileBaseWidget::addTile(TileItem& newItem)
@@ -71,6 +77,20 @@ void TileBaseWidget::addTile(TileItem& newItem)
 
 void TileBaseWidget::removeTile(const TileItem& removed)
 {
+    if (m_virtualized) {
+        // the rows below move up without animating, their tiles may not exist
+        QHash<int, TileItem*>::const_iterator it = m_visibleTiles.constBegin();
+        for (; it != m_visibleTiles.constEnd(); ++it) {
+            if (it.value() == &removed) {
+                m_urlList.removeAt(it.key());
+                break;
+            }
+        }
+        layoutTiles();
+        adjustContainerHeight();
+        return;
+    }
+
     if (!m_slideAnimationGroup)
         m_slideAnimationGroup = new QParallelAnimationGroup();
     m_slideAnimationGroup->clear();
@@ -97,10 +117,34 @@ void TileBaseWidget::removeTile(const TileItem& removed)
 
 void TileBaseWidget::removeAll()
 {
+    if (m_virtualized) {
+        // keep them for the next setUrlList()
+        for (int i = 0; i < m_tileList.size(); ++i)
+            m_tileList.at(i)->hide();
+        m_recycledTiles += m_tileList;
+        m_tileList.clear();
+        m_visibleTiles.clear();
+        m_urlList.clear();
+        m_firstVisible = 0;
+        m_lastVisible = -1;
+        return;
+    }
     for (int i = m_tileList.size() - 1; i >= 0; --i)
         delete m_tileList.takeAt(i);
 }
 
+/*!
+  Switches the widget to virtualized mode, showing \a list. Tiles are
+  created with createTile() for the rows that are visible in the
+  pannable container only, and recycled as the rows scroll out.
+*/
+void TileBaseWidget::setUrlList(const UrlList& list)
+{
+    m_virtualized = true;
+    m_urlList = list;
+    updateVisibleTiles(true);
+}
+
 bool TileBaseWidget::contains(TileItem& item)
 {
     return m_tileList.contains(&item);
@@ -120,17 +164,20 @@ int TileBaseWidget::titleVMargin()
 
 int TileBaseWidget::tileTopVMargin() 
 {
-    return titleVMargin() + QFontMetrics(FontFactory::instance()->big()).height() + s_tileTopMargin;
+    return titleVMargin() + FontFactory::instance()->bigMetrics().height() + s_tileTopMargin;
 }
 
 QSize TileBaseWidget::doLayoutTiles(const QRectF& rect_, int hTileNum, int vTileNum, int marginX, int marginY, int fixedItemWidth, int fixedItemHeight)
 {
-    if (!m_tileList.size())
+    int tileCount = m_virtualized ? m_urlList.size() : m_tileList.size();
+    if (!tileCount) {
+        updateVisibleTiles(true);
         return QSize(0, 0) ;
+    }
 
     m_titleRect.setLeft(rect().left() + marginX);
     m_titleRect.setTop(titleVMargin());
-    m_titleRect.setHeight(QFontMetrics(FontFactory::instance()->big()).height());
+    m_titleRect.setHeight(FontFactory::instance()->bigMetrics().height());
     m_titleRect.setWidth(rect_.width());    
 
     int y = rect_.top() + marginY;
@@ -138,17 +185,97 @@ QSize TileBaseWidget::doLayoutTiles(const QRectF& rect_, int hTileNum, int vTile
 
     int tileWidth = fixedItemWidth == -1 ? (rect_.width() - (hTileNum + 1)*marginX) / hTileNum : fixedItemWidth;
     int tileHeight = fixedItemHeight == -1 ?(rect_.height() - (vTileNum)*marginY) / vTileNum : fixedItemHeight;
-    int tileCount = m_tileList.size();
-    int i = 0;
-    for (; i < tileCount; ++i) {
-        if (i >= hTileNum && i%hTileNum == 0) {
-            y+=(tileHeight + marginY);
-            x = rect_.left() + marginX;
+
+    m_gridOrigin = QPointF(x, y);
+    m_gridTileSize = QSizeF(tileWidth, tileHeight);
+    m_gridMargin = QSizeF(marginX, marginY);
+    m_gridColumns = hTileNum;
+
+    if (m_virtualized)
+        updateVisibleTiles(true);
+    else {
+        for (int i = 0; i < tileCount; ++i)
+            m_tileList.at(i)->setRect(tileRect(i));
+    }
+    return QSize(tileWidth * hTileNum, tileRect(tileCount - 1).bottom());
+}
+
+QRectF TileBaseWidget::tileRect(int index) const
+{
+    int row = index / m_gridColumns;
+    int column = index % m_gridColumns;
+    return QRectF(m_gridOrigin.x() + column * (m_gridTileSize.width() + m_gridMargin.width()),
+                  m_gridOrigin.y() + row * (m_gridTileSize.height() + m_gridMargin.height()),
+                  m_gridTileSize.width(), m_gridTileSize.height());
+}
+
+/*!
+  Makes sure that exactly the rows intersecting the visible part of the
+  container, plus a margin, have a tile. Tiles of the rows that went out
+  are reused for the ones coming in.
+*/
+void TileBaseWidget::updateVisibleTiles(bool relayout)
+{
+    if (!m_virtualized)
+        return;
+
+    int first = 0;
+    int last = -1;
+    qreal rowHeight = m_gridTileSize.height() + m_gridMargin.height();
+    if (!m_urlList.isEmpty() && rowHeight > 0) {
+        // the container is panned by moving this widget inside it
+        QRectF visible(-pos(), parentWidget() ? parentWidget()->size() : size());
+        visible.adjust(0, -s_tilePrefetchMargin, 0, s_tilePrefetchMargin);
+        int firstRow = qMax(0, int((visible.top() - m_gridOrigin.y()) / rowHeight));
+        int lastRow = qMax(0, int((visible.bottom() - m_gridOrigin.y()) / rowHeight));
+        first = qMin(firstRow * m_gridColumns, m_urlList.size());
+        last = qMin((lastRow + 1) * m_gridColumns, m_urlList.size()) - 1;
+    }
+    if (!relayout && first == m_firstVisible && last == m_lastVisible)
+        return;
+    m_firstVisible = first;
+    m_lastVisible = last;
+
+    QHash<int, TileItem*> visibleTiles;
+    TileList spareTiles;
+    QHash<int, TileItem*>::const_iterator it = m_visibleTiles.constBegin();
+    for (; it != m_visibleTiles.constEnd(); ++it) {
+        if (it.key() >= first && it.key() <= last)
+            visibleTiles.insert(it.key(), it.value());
+        else
+            spareTiles.append(it.value());
+    }
+
+    m_tileList.clear();
+    for (int i = first; i <= last; ++i) {
+        TileItem* tile = visibleTiles.value(i);
+        // after a relayout the row may show a different item, the tile is
+        // only repainted if it does
+        if (tile && relayout)
+            tile->setUrlItem(m_urlList.at(i));
+        if (!tile) {
+            if (!spareTiles.isEmpty())
+                tile = spareTiles.takeLast();
+            else if (!m_recycledTiles.isEmpty())
+                tile = m_recycledTiles.takeLast();
+            if (tile) {
+                tile->setUrlItem(m_urlList.at(i));
+                tile->setEditMode(m_editMode);
+                tile->show();
+            } else {
+                tile = createTile(m_urlList.at(i));
+                tile->setEditMode(m_editMode);
+                emit tileCreated(tile);
+            }
+            visibleTiles.insert(i, tile);
         }
-        m_tileList.at(i)->setRect(QRectF(x, y, tileWidth, tileHeight));
-        x+=(tileWidth + marginX);
+        tile->setRect(tileRect(i));
+        m_tileList.append(tile);
     }
-    return QSize(tileWidth * hTileNum, y + tileHeight);
+    for (int i = 0; i < spareTiles.size(); ++i)
+        spareTiles.at(i)->hide();
+    m_recycledTiles += spareTiles;
+    m_visibleTiles = visibleTiles;
 }
 
 void TileBaseWidget::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
@@ -168,6 +295,13 @@ void TileBaseWidget::mousePressEvent(QGraphicsSceneMouseEvent*)
 {
 }
 
+QVariant TileBaseWidget::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+    if (change == QGraphicsItem::ItemPositionHasChanged)
+        updateVisibleTiles();
+    return QGraphicsWidget::itemChange(change, value);
+}
+
 void TileBaseWidget::addMoveAnimation(TileItem& item, int delay, const QPointF& oldPos, const QPointF& newPos)
 {
     // animate all the way down to the current window
@@ -183,10 +317,11 @@ void TileBaseWidget::addMoveAnimation(TileItem& item, int delay, const QPointF&
 
 void TileBaseWidget::adjustContainerHeight()
 {
-    if (m_tileList.size() == 0)
+    if (m_virtualized ? m_urlList.isEmpty() : m_tileList.isEmpty())
         return;
     // check if container needs to be resized
-    int lastRectBottom = m_tileList.at(m_tileList.size()-1)->rect().bottom() + s_containerYBottomMargin;
+    QRectF lastRect = m_virtualized ? tileRect(m_urlList.size() - 1) : m_tileList.last()->rect();
+    int lastRectBottom = lastRect.bottom() + s_containerYBottomMargin;
     if (rect().height() > lastRectBottom) {
         setMinimumHeight(lastRectBottom);
         resize(QSizeF(size().width(), lastRectBottom));
@@ -220,7 +355,7 @@ void TabWidget::removeTile(const TileItem& removed)
 {
     // FIXME: when tab is full, fake items dont work
     // insert a fake marker item in place
-    NewWindowMarkerTileItem* emptyItem = new NewWindowMarkerTileItem(this, *(new UrlItem(QUrl(), "", 0)));
+    NewWindowMarkerTileItem* emptyItem = new NewWindowMarkerTileItem(this, UrlItem(QUrl(), ""));
     for (int i = 0; i < m_tileList.size(); ++i) {
         if (m_tileList.at(i)->fixed()) {
             emptyItem->setRect(m_tileList.at(i-1)->rect());
@@ -238,6 +373,11 @@ HistoryWidget::HistoryWidget(QGraphicsItem* parent, Qt::WindowFlags wFlags)
 {
 }
 
+TileItem* HistoryWidget::createTile(const UrlItem& urlItem)
+{
+    return new ThumbnailTileItem(this, urlItem);
+}
+
 void HistoryWidget::removeTile(const TileItem& removed)
 {
     HistoryStore::instance()->remove(removed.urlItem()->url());
@@ -265,6 +405,11 @@ BookmarkWidget::BookmarkWidget(QGraphicsItem* parent, Qt::WindowFlags wFlags)
 {
 }
 
+TileItem* BookmarkWidget::createTile(const UrlItem& urlItem)
+{
+    return new ListTileItem(this, urlItem);
+}
+
 void BookmarkWidget::removeTile(const TileItem& removed)
 {
     BookmarkStore::instance()->remove(removed.urlItem()->url());
@@ -302,4 +447,49 @@ void PopupWidget::layoutTiles()
     setMinimumHeight(doLayoutTiles(r, 1, -1, s_tileMargin, -1, -1, s_searchItemTileHeight).height());
 }
 
+/*!
+  Moves the tiles out of the list but keeps them, the popup content is
+  rebuilt on every key press and most rows stay the same.
+*/
+void PopupWidget::recycleTiles()
+{
+    m_recycledTiles += m_tileList;
+    m_tileList.clear();
+}
+
+/*!
+  Returns the recycled tile that shows \a urlItem, or 0 if there is none.
+  Suggestions share the url, the title tells them apart.
+*/
+TileItem* PopupWidget::takeRecycledTile(const UrlItem& urlItem)
+{
+    for (int i = 0; i < m_recycledTiles.size(); ++i) {
+        const UrlItem* shown = m_recycledTiles.at(i)->urlItem();
+        if (shown->url() == urlItem.url() && shown->title() == urlItem.title()) {
+            TileItem* tile = m_recycledTiles.takeAt(i);
+            tile->show();
+            return tile;
+        }
+    }
+    return 0;
+}
+
+/*!
+  Returns any recycled tile, or 0 if there is none left.
+*/
+TileItem* PopupWidget::takeRecycledTile()
+{
+    if (m_recycledTiles.isEmpty())
+        return 0;
+    TileItem* tile = m_recycledTiles.takeFirst();
+    tile->show();
+    return tile;
+}
+
+void PopupWidget::hideRecycledTiles()
+{
+    for (int i = 0; i < m_recycledTiles.size(); ++i)
+        m_recycledTiles.at(i)->hide();
+}
+
 
@@ -22,6 +22,7 @@
 #define TileContainerWidget_h_
 
 #include <QGraphicsWidget>
+#include <QHash>
 #include "TileItem.h"
 
 class QGraphicsSceneMouseEvent;
@@ -38,6 +39,8 @@ public:
     virtual bool contains(TileItem& item);
     virtual void layoutTiles() = 0;
 
+    void setUrlList(const UrlList& list);
+
     void setEditMode(bool on);
     bool editMode() const { return m_editMode; }
 
@@ -50,6 +53,7 @@ public:
     //
 Q_SIGNALS:
     void closeWidget();
+    void tileCreated(TileItem*);
 
 protected:
     TileBaseWidget(const QString& title, QGraphicsItem* parent, Qt::WindowFlags wFlags = 0);
@@ -57,18 +61,24 @@ protected:
     int titleVMargin();
     int tileTopVMargin();
     QSize doLayoutTiles(const QRectF& rect, int hTileNum, int vTileNum, int marginX, int marginY, int fixedItemWidth = -1, int fixedItemHeight = -1);
+    virtual TileItem* createTile(const UrlItem&) { return 0; }
 
 private:
     void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget);
     void mouseReleaseEvent(QGraphicsSceneMouseEvent* event);
     void mousePressEvent(QGraphicsSceneMouseEvent*);
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value);
     void addMoveAnimation(TileItem& item, int delay, const QPointF& oldPos, const QPointF& newPos);
+    QRectF tileRect(int index) const;
+    void updateVisibleTiles(bool relayout = false);
 
 private Q_SLOTS:
     void adjustContainerHeight();
 
 protected:
     TileList m_tileList;
+    // tiles not in use, hidden
+    TileList m_recycledTiles;
     QString m_title;
     QRectF m_titleRect;
 
@@ -76,6 +86,21 @@ private:
     QParallelAnimationGroup* m_slideAnimationGroup;
     bool m_editMode;
     bool m_moved;
+
+    // virtualized mode, set by setUrlList(). only the tiles of the visible
+    // rows exist, m_tileList holds them in row order
+    bool m_virtualized;
+    UrlList m_urlList;
+    // index in m_urlList -> tile
+    QHash<int, TileItem*> m_visibleTiles;
+    int m_firstVisible;
+    int m_lastVisible;
+
+    // grid computed by doLayoutTiles()
+    QPointF m_gridOrigin;
+    QSizeF m_gridTileSize;
+    QSizeF m_gridMargin;
+    int m_gridColumns;
 };
 
 // subclasses
@@ -96,6 +121,9 @@ public:
     
     void removeTile(const TileItem& removed);
     void layoutTiles();
+
+protected:
+    TileItem* createTile(const UrlItem& urlItem);
 };
 
 class BookmarkWidget : public TileBaseWidget {
@@ -105,6 +133,9 @@ public:
 
     void removeTile(const TileItem& removed);
     void layoutTiles();
+
+protected:
+    TileItem* createTile(const UrlItem& urlItem);
 };
 
 class PopupWidget : public TileBaseWidget {
@@ -114,6 +145,11 @@ public:
 
     void removeTile(const TileItem& removed);
     void layoutTiles();
+
+    void recycleTiles();
+    TileItem* takeRecycledTile(const UrlItem& urlItem);
+    TileItem* takeRecycledTile();
+    void hideRecycledTiles();
 };
 
 #endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#include "TileDecorations.h"
+
+#include <QPainter>
+
+// a few tile sizes per orientation
+static const int s_maxFrameCacheCost = 1024;
+static const int s_tilesRound = 10;
+static const int s_listTilesRound = 2;
+static const int s_dropShadowOffset = 3;
+// the pen is centered on the tile rect, half of it falls outside
+static const int s_frameMargin = 1;
+
+/*!
+  \class TileDecorations renders the parts that all the tiles share, once
+  per tile size, so that painting a tile is mostly blitting.
+*/
+TileDecorations* TileDecorations::instance()
+{
+    static TileDecorations* decorations = 0;
+    if (!decorations)
+        decorations = new TileDecorations();
+    return decorations;
+}
+
+TileDecorations::TileDecorations()
+    : m_closeIcon(":/data/icon/48x48/close_item_48.png")
+    , m_defaultIcon(":/data/icon/48x48/defaulticon_48.png")
+{
+    m_frames.setMaxCost(s_maxFrameCacheCost);
+}
+
+/*!
+  Draws the background of a tile at \a rect: the white rounded frame,
+  with the drop shadow for thumbnail tiles.
+*/
+void TileDecorations::drawFrame(QPainter* painter, FrameStyle style, const QRectF& rect)
+{
+    painter->drawPixmap(rect.topLeft() - QPointF(s_frameMargin, s_frameMargin), frame(style, rect.size().toSize()));
+}
+
+/*!
+  Returns the frame for a tile of \a size, the tile starts at
+  s_frameMargin in both directions.
+*/
+QPixmap TileDecorations::frame(FrameStyle style, const QSize& size)
+{
+    if (size.isEmpty())
+        return QPixmap();
+    quint64 key = (quint64(style) << 32) | (quint64(size.width()) << 16) | quint64(size.height());
+    if (QPixmap* cached = m_frames.object(key))
+        return *cached;
+
+    int extent = 2 * s_frameMargin + (style == ThumbnailFrame ? s_dropShadowOffset : 0);
+    QPixmap* pixmap = new QPixmap(size + QSize(extent, extent));
+    pixmap->fill(Qt::transparent);
+    QPainter painter(pixmap);
+    painter.setRenderHints(QPainter::Antialiasing);
+    QRectF r(QPointF(s_frameMargin, s_frameMargin), size);
+    int round = s_listTilesRound;
+    if (style == ThumbnailFrame) {
+        // QGraphicsDropShadowEffect doesnt perform well on n900.
+        // FIXME: dropshadow shouldnt be a rect
+        painter.setPen(QColor(40, 40, 40));
+        painter.setBrush(QColor(20, 20, 20));
+        painter.drawRoundedRect(r.translated(s_dropShadowOffset, s_dropShadowOffset), s_tilesRound, s_tilesRound);
+        round = s_tilesRound;
+    }
+    painter.setBrush(Qt::white);
+    painter.setPen(Qt::gray);
+    painter.drawRoundedRect(r, round, round);
+    painter.end();
+
+    QPixmap result = *pixmap;
+    m_frames.insert(key, pixmap, qMax(1, pixmap->width() * pixmap->height() * pixmap->depth() / 8 / 1024));
+    return result;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef TileDecorations_h_
+#define TileDecorations_h_
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QRectF>
+#include <QSize>
+
+class QPainter;
+
+class TileDecorations {
+public:
+    enum FrameStyle {
+        ThumbnailFrame,
+        ListFrame
+    };
+
+    static TileDecorations* instance();
+
+    void drawFrame(QPainter* painter, FrameStyle style, const QRectF& rect);
+    const QImage* closeIcon() const { return &m_closeIcon; }
+    const QImage& defaultIcon() const { return m_defaultIcon; }
+
+private:
+    TileDecorations();
+
+    QPixmap frame(FrameStyle style, const QSize& size);
+
+    QImage m_closeIcon;
+    // for the tiles without a thumbnail
+    QImage m_defaultIcon;
+    // cost is in kilobytes
+    QCache<quint64, QPixmap> m_frames;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "TileItem.h"
 #include "FontFactory.h"
 #include "TileContainerWidget.h"
+#include "TileDecorations.h"
 
 #include <QGraphicsWidget>
 #include <QPainter>
@@ -49,16 +50,31 @@ TileItem::TileItem(QGraphicsWidget* parent, TileType type, const UrlItem& urlIte
     , m_fixed(false)
     , m_oldRect(-1, -1, -1, -1)
 {
-#ifndef Q_OS_SYMBIAN
-    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
-#endif    
     connect(&m_longpressTimer, SIGNAL(timeout()), this, SLOT(longpressTimeout()));
     m_longpressTimer.setSingleShot(true);
 }
 
 TileItem::~TileItem()
 {
-    delete m_closeIcon;
+}
+
+/*!
+  Makes a recycled tile show \a urlItem, the tile is laid out and painted
+  again only if the url, the title or the thumbnail changed.
+*/
+void TileItem::setUrlItem(const UrlItem& urlItem)
+{
+    if (showsUrlItem(urlItem))
+        return;
+    m_urlItem = urlItem;
+    m_oldRect = QRectF(-1, -1, -1, -1);
+    update(boundingRect());
+}
+
+bool TileItem::showsUrlItem(const UrlItem& urlItem) const
+{
+    return urlItem.url() == m_urlItem.url() && urlItem.title() == m_urlItem.title()
+        && urlItem.hasThumbnail() == m_urlItem.hasThumbnail() && urlItem.thumbnailPath() == m_urlItem.thumbnailPath();
 }
 
 void TileItem::setTilePos(const QPointF& pos) 
@@ -72,12 +88,10 @@ void TileItem::setEditMode(bool on)
     if (!m_editable)
         return;
     if (on && !m_closeIcon) {
-        m_closeIcon = new QImage(":/data/icon/48x48/close_item_48.png");
+        m_closeIcon = TileDecorations::instance()->closeIcon();
         setEditIconRect();
-    } else if (!on) {
-        delete m_closeIcon;
+    } else if (!on)
         m_closeIcon = 0;
-    }
     update(boundingRect());
 }
 
@@ -102,15 +116,6 @@ void TileItem::paintExtra(QPainter* painter)
     }
 }
 
-void TileItem::addDropShadow(QPainter& painter, const QRectF rect)
-{
-    // FIXME: dropshadow shouldnt be a rect
-    painter.setPen(QColor(40, 40, 40));
-    painter.setBrush(QColor(20, 20, 20));
-    QRectF r(rect); r.moveTopLeft(r.topLeft() + QPointF(3, 3));
-    painter.drawRoundedRect(r, s_tilesRound, s_tilesRound);
-}
-
 QRectF TileItem::boundingRect() const
 {
     QRectF r(rect());
@@ -195,14 +200,24 @@ void TileItem::closeItem()
 ThumbnailTileItem::ThumbnailTileItem(QGraphicsWidget* parent, const UrlItem& urlItem, bool editable)
     : TileItem(parent, ThumbnailTile, urlItem, editable)
 {
-    if (!urlItem.thumbnail())
-        m_defaultIcon = QImage(":/data/icon/48x48/defaulticon_48.png");
+    if (!urlItem.hasThumbnail())
+        m_defaultIcon = TileDecorations::instance()->defaultIcon();
 }
 
 ThumbnailTileItem::~ThumbnailTileItem()
 {
 }
 
+void ThumbnailTileItem::setUrlItem(const UrlItem& urlItem)
+{
+    if (showsUrlItem(urlItem))
+        return;
+    TileItem::setUrlItem(urlItem);
+    // the previous item may have had a thumbnail or not
+    m_defaultIcon = urlItem.hasThumbnail() ? QImage() : TileDecorations::instance()->defaultIcon();
+    m_scaledThumbnail = QImage();
+}
+
 void ThumbnailTileItem::doLayoutTile()
 {
     const QFont& f = FontFactory::instance()->small();
@@ -217,12 +232,20 @@ void ThumbnailTileItem::doLayoutTile()
         m_thumbnailRect.moveCenter(rect().center() - rect().topLeft());
     } else {
         // stretch thumbnail
-        m_thumbnailRect.adjust(0, 0, 0, -(QFontMetrics(f).height() + 3));
+        m_thumbnailRect.adjust(0, 0, 0, -(FontFactory::instance()->smallMetrics().height() + 3));
+    }
+    m_title = FontFactory::instance()->elidedText(f, m_urlItem.title(), Qt::ElideRight, m_textRect.width() - s_tilesRound);
+    // scale on the fly, only when default icon is not present. layout happens on the first paint,
+    // so is the loading of the thumbnail
+    if (m_defaultIcon.isNull()) {
+        QSize size = m_thumbnailRect.size().toSize();
+        QImage thumbnail = m_urlItem.thumbnail(size);
+        // the box filtered level is less than twice the size, fast scaling does fine from there
+        if (thumbnail.size() == size || thumbnail.isNull())
+            m_scaledThumbnail = thumbnail;
+        else
+            m_scaledThumbnail = thumbnail.scaled(size, Qt::KeepAspectRatioByExpanding, Qt::FastTransformation);
     }
-    m_title = QFontMetrics(f).elidedText(m_urlItem.title(), Qt::ElideRight, m_textRect.width() - s_tilesRound);
-    // scale on the fly, only when default icon is not present
-    if (m_defaultIcon.isNull() && m_urlItem.thumbnail())
-        m_scaledThumbnail = m_urlItem.thumbnail()->scaled(m_thumbnailRect.size().toSize(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
 }
 
 void ThumbnailTileItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
@@ -231,23 +254,18 @@ void ThumbnailTileItem::paint(QPainter* painter, const QStyleOptionGraphicsItem*
 
     QRectF r(rect()); 
     painter->setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
-    // QGraphicsDropShadowEffect doesnt perform well on n900.
-    addDropShadow(*painter, r);
- 
-    painter->setBrush(Qt::white);
-    painter->setPen(Qt::gray);
-    painter->drawRoundedRect(r, s_tilesRound, s_tilesRound);
+    // frame and drop shadow
+    TileDecorations::instance()->drawFrame(painter, TileDecorations::ThumbnailFrame, r);
     // thumbnail
     if (m_defaultIcon.isNull())
         painter->drawImage(r.topLeft() + m_thumbnailRect.topLeft(), m_scaledThumbnail, m_thumbnailRect);
     else
         painter->drawImage(r.topLeft() + m_thumbnailRect.topLeft(), m_defaultIcon);
-    painter->setFont(FontFactory::instance()->small());
     painter->setPen(Qt::black);
     // title
     QRectF textRect(m_textRect);
     textRect.moveTopLeft(r.topLeft() + textRect.topLeft());
-    painter->drawText(textRect, Qt::AlignHCenter|Qt::AlignBottom, m_title);
+    FontFactory::instance()->drawText(painter, FontFactory::instance()->small(), textRect, Qt::AlignHCenter|Qt::AlignBottom, m_title);
     paintExtra(painter);
 }
 
@@ -329,17 +347,16 @@ void ListTileItem::doLayoutTile()
     m_titleRect = r;
     m_urlRect = r;
 
-    const QFont& fmedium = FontFactory::instance()->medium();
-    const QFont& fsmall = FontFactory::instance()->small();
-    QFontMetrics fmfmedium(fmedium);
-    QFontMetrics fmfsmall(fsmall);
+    FontFactory* fonts = FontFactory::instance();
+    const QFontMetrics& fmfmedium = fonts->mediumMetrics();
+    const QFontMetrics& fmfsmall = fonts->smallMetrics();
 
     int fontHeightRatio = r.height() / (fmfmedium.height() + fmfsmall.height() + 5);
     m_titleRect.setHeight(fmfmedium.height() * fontHeightRatio);
     m_urlRect.setTop(m_titleRect.bottom() + 5); 
 
-    m_title = fmfmedium.elidedText(m_urlItem.title(), Qt::ElideRight, r.width());
-    m_url = fmfsmall.elidedText(m_urlItem.url().toString(), Qt::ElideRight, r.width());
+    m_title = fonts->elidedText(fonts->medium(), m_urlItem.title(), Qt::ElideRight, r.width());
+    m_url = fonts->elidedText(fonts->small(), m_urlItem.url().toString(), Qt::ElideRight, r.width());
 }
 
 void ListTileItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
@@ -348,24 +365,18 @@ void ListTileItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* /*op
 
     QRectF r(rect()); 
 
-    // QGraphicsDropShadowEffect doesnt perform well on n900.
     painter->setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
- 
-    painter->setBrush(Qt::white);
-    painter->setPen(Qt::gray);
-    painter->drawRoundedRect(r, 2, 2);
+    TileDecorations::instance()->drawFrame(painter, TileDecorations::ListFrame, r);
 
     QRectF textRect(m_titleRect);
     textRect.moveTopLeft(textRect.topLeft() + r.topLeft());
     painter->setPen(Qt::black);
-    painter->setFont(FontFactory::instance()->medium());
-    painter->drawText(textRect, Qt::AlignLeft|Qt::AlignVCenter, m_title);
+    FontFactory::instance()->drawText(painter, FontFactory::instance()->medium(), textRect, Qt::AlignLeft|Qt::AlignVCenter, m_title);
 
     textRect = m_urlRect;
     textRect.moveTopLeft(textRect.topLeft() + r.topLeft());
     painter->setPen(QColor(110, 110, 110));
-    painter->setFont(FontFactory::instance()->small());
-    painter->drawText(textRect, Qt::AlignLeft|Qt::AlignVCenter, m_url);
+    FontFactory::instance()->drawText(painter, FontFactory::instance()->small(), textRect, Qt::AlignLeft|Qt::AlignVCenter, m_url);
 
     paintExtra(painter);
 }
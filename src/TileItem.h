@@ -47,6 +47,7 @@ public:
     virtual ~TileItem();
     
     const UrlItem* urlItem() const { return &m_urlItem; }
+    virtual void setUrlItem(const UrlItem& urlItem);
 
     void setTilePos(const QPointF& pos);
     QPointF tilePos() const { return rect().topLeft(); }
@@ -65,7 +66,7 @@ Q_SIGNALS:
 protected:
     TileItem(QGraphicsWidget* parent, TileType type, const UrlItem& urlItem, bool editable = true);
     void paintExtra(QPainter* painter);
-    void addDropShadow(QPainter& painter, const QRectF rect);
+    bool showsUrlItem(const UrlItem& urlItem) const;
     void layoutTile();
     QRectF boundingRect() const;
 
@@ -80,7 +81,8 @@ protected Q_SLOTS:
 protected:
     UrlItem m_urlItem;
     bool m_selected;
-    QImage* m_closeIcon;
+    // shared, owned by TileDecorations
+    const QImage* m_closeIcon;
     QRectF m_closeIconRect;
 
 private:
@@ -104,6 +106,8 @@ class ThumbnailTileItem : public TileItem {
 public:
     ThumbnailTileItem(QGraphicsWidget* parent, const UrlItem& urlItem, bool editable = true);
     ~ThumbnailTileItem();
+
+    void setUrlItem(const UrlItem& urlItem);
     
 private:
     void doLayoutTile();
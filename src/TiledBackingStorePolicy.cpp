@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "TiledBackingStorePolicy.h"
+#include "WebView.h"
+
+#include <math.h>
+
+namespace {
+const QSize s_tileSize(256, 256);
+const int s_bytesPerPixel = 4;
+const int s_defaultMemoryBudget = 32 * 1024 * 1024;
+const int s_idleTileCreationDelay = 25;
+// the tiles are painted on the ui thread, leave time for the scroll
+// animation while prefetching during a fling
+const int s_prefetchTileCreationDelay = 50;
+// pixels per second after which a pan is treated as a fling
+const qreal s_flingVelocity = 1000;
+// how far ahead of a fling the cover area should reach, in seconds
+const qreal s_lookAhead = .4;
+const QSizeF s_coverAreaMultiplier(1.5, 1.5);
+const QSizeF s_maxCoverAreaMultiplier(3., 4.);
+const QSizeF s_keepAreaMultiplier(2., 2.5);
+const QSizeF s_inactiveAreaMultiplier(1., 1.);
+
+// Rough size of the tiles the backing store keeps for the multiplier,
+// no tiles are created outside of the contents
+qreal areaCost(const QSizeF& viewportSize, const QSizeF& contentsSize, const QSizeF& multiplier)
+{
+    return qMin(viewportSize.width() * multiplier.width(), contentsSize.width())
+        * qMin(viewportSize.height() * multiplier.height(), contentsSize.height()) * s_bytesPerPixel;
+}
+
+QSizeF fitToBudget(const QSizeF& multiplier, const QSizeF& minimum, qreal budget, const QSizeF& viewportSize, const QSizeF& contentsSize)
+{
+    qreal cost = areaCost(viewportSize, contentsSize, multiplier);
+    if (cost <= budget)
+        return multiplier;
+    qreal factor = sqrt(budget / cost);
+    return QSizeF(qMax(minimum.width(), multiplier.width() * factor), qMax(minimum.height(), multiplier.height() * factor));
+}
+
+qreal coverForFling(qreal multiplier, qreal maxMultiplier, qreal viewportLength, qreal velocity, qreal flingDistance)
+{
+    if (viewportLength <= 0)
+        return multiplier;
+    // reach where the fling lands, or at least a bit ahead
+    qreal distance = qMax(qAbs(velocity) * s_lookAhead, qAbs(flingDistance));
+    // the cover area is centered on the viewport, so it has to grow on both sides
+    return qBound(multiplier, 1 + 2 * distance / viewportLength, maxMultiplier);
+}
+
+QSizeF quantize(const QSizeF& multiplier)
+{
+    // avoid poking the backing store for every pixel of scroll
+    return QSizeF(qRound(multiplier.width() * 4) / 4., qRound(multiplier.height() * 4) / 4.);
+}
+
+QSizeF expandedTo(const QSizeF& multiplier, const QSizeF& minimum)
+{
+    return QSizeF(qMax(multiplier.width(), minimum.width()), qMax(multiplier.height(), minimum.height()));
+}
+
+}
+
+/*!
+  \class TiledBackingStorePolicy tunes the tiled backing store of the web
+  views at runtime.
+
+  The cover area grows in the direction of a fling until it reaches
+  where the viewport is going to land. The backing store creates the
+  tiles closest to the viewport first, so the tiles along the trajectory
+  get created in the order the viewport passes them. The keep areas are sized so that all the
+  views together stay within the memory budget: hidden views only keep
+  their visible area and the active view gets the rest.
+*/
+TiledBackingStorePolicy* TiledBackingStorePolicy::instance()
+{
+    static TiledBackingStorePolicy* s_instance = 0;
+    if (!s_instance)
+        s_instance = new TiledBackingStorePolicy();
+    return s_instance;
+}
+
+TiledBackingStorePolicy::TiledBackingStorePolicy()
+    : m_memoryBudget(s_defaultMemoryBudget)
+{
+}
+
+TiledBackingStorePolicy::Parameters::Parameters()
+    : tileCreationDelay(-1)
+{
+}
+
+bool TiledBackingStorePolicy::Parameters::operator==(const Parameters& other) const
+{
+    return tileCreationDelay == other.tileCreationDelay
+        && coverAreaMultiplier == other.coverAreaMultiplier
+        && keepAreaMultiplier == other.keepAreaMultiplier;
+}
+
+void TiledBackingStorePolicy::setMemoryBudget(int bytes)
+{
+    m_memoryBudget = bytes;
+    updateAll();
+}
+
+void TiledBackingStorePolicy::addView(WebView* view)
+{
+    // changing the tile size throws away all the tiles, so it is not tuned
+    view->page()->setProperty("_q_TiledBackingStoreTileSize", s_tileSize);
+    m_views.insert(view, ViewState());
+    updateAll();
+}
+
+void TiledBackingStorePolicy::removeView(WebView* view)
+{
+    m_views.remove(view);
+    updateAll();
+}
+
+void TiledBackingStorePolicy::viewVisibilityChanged(WebView* view)
+{
+    if (m_views.contains(view))
+        updateAll();
+}
+
+/*!
+  Updates the backing store of \a view for the viewport and contents
+  size (in scene coordinates), the current pan \a velocity in pixels
+  per second and the distance the kinetic scroll still travels.
+*/
+void TiledBackingStorePolicy::update(WebView* view, const QSizeF& viewportSize, const QSizeF& contentsSize,
+                                     const QPointF& velocity, const QPointF& flingDistance)
+{
+    QHash<WebView*, ViewState>::iterator it = m_views.find(view);
+    if (it == m_views.end())
+        return;
+
+    it->viewportSize = viewportSize;
+    it->contentsSize = contentsSize;
+    it->velocity = velocity;
+    it->flingDistance = flingDistance;
+
+    int budget = m_memoryBudget;
+    QHash<WebView*, ViewState>::const_iterator i = m_views.constBegin();
+    for (; i != m_views.constEnd(); ++i) {
+        if (i.key() != view && !i.key()->isVisible())
+            budget -= inactiveViewCost(i.value());
+    }
+    apply(view, *it, budget);
+}
+
+void TiledBackingStorePolicy::updateAll()
+{
+    QHash<WebView*, ViewState>::iterator it = m_views.begin();
+    for (; it != m_views.end(); ++it) {
+        ViewState state = it.value();
+        update(it.key(), state.viewportSize, state.contentsSize, state.velocity, state.flingDistance);
+    }
+}
+
+int TiledBackingStorePolicy::inactiveViewCost(const ViewState& state) const
+{
+    return int(areaCost(state.viewportSize, state.contentsSize, s_inactiveAreaMultiplier));
+}
+
+void TiledBackingStorePolicy::apply(WebView* view, ViewState& state, int budget)
+{
+    Parameters parameters;
+    parameters.tileCreationDelay = s_idleTileCreationDelay;
+
+    if (!view->isVisible()) {
+        parameters.coverAreaMultiplier = s_inactiveAreaMultiplier;
+        parameters.keepAreaMultiplier = s_inactiveAreaMultiplier;
+    } else {
+        // the visible area is the least we can do, no matter the budget
+        qreal activeBudget = qMax<qreal>(budget, inactiveViewCost(state));
+        bool flingX = qAbs(state.velocity.x()) > s_flingVelocity;
+        bool flingY = qAbs(state.velocity.y()) > s_flingVelocity;
+
+        QSizeF cover(coverForFling(s_coverAreaMultiplier.width(), s_maxCoverAreaMultiplier.width(), state.viewportSize.width(),
+                                   state.velocity.x(), state.flingDistance.x()),
+                     coverForFling(s_coverAreaMultiplier.height(), s_maxCoverAreaMultiplier.height(), state.viewportSize.height(),
+                                   state.velocity.y(), state.flingDistance.y()));
+        // the multipliers are symmetric, so the best we can do for a fling
+        // along one axis is to stop covering the other one
+        if (flingY && !flingX)
+            cover.setWidth(s_inactiveAreaMultiplier.width());
+        else if (flingX && !flingY)
+            cover.setHeight(s_inactiveAreaMultiplier.height());
+
+        QSizeF keep = expandedTo(s_keepAreaMultiplier, cover);
+        keep = fitToBudget(keep, cover, activeBudget, state.viewportSize, state.contentsSize);
+        cover = fitToBudget(cover, s_inactiveAreaMultiplier, activeBudget, state.viewportSize, state.contentsSize);
+
+        parameters.coverAreaMultiplier = quantize(cover);
+        parameters.keepAreaMultiplier = expandedTo(quantize(keep), parameters.coverAreaMultiplier);
+        if (flingX || flingY)
+            parameters.tileCreationDelay = s_prefetchTileCreationDelay;
+    }
+
+    if (parameters == state.applied)
+        return;
+
+    state.applied = parameters;
+    view->page()->setProperty("_q_TiledBackingStoreTileCreationDelay", parameters.tileCreationDelay);
+    view->page()->setProperty("_q_TiledBackingStoreCoverAreaMultiplier", parameters.coverAreaMultiplier);
+    view->page()->setProperty("_q_TiledBackingStoreKeepAreaMultiplier", parameters.keepAreaMultiplier);
+}
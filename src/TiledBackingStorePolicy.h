@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TiledBackingStorePolicy_h_
+#define TiledBackingStorePolicy_h_
+
+#include "yberconfig.h"
+
+#include <QHash>
+#include <QPointF>
+#include <QSize>
+#include <QSizeF>
+
+class WebView;
+
+class TiledBackingStorePolicy {
+public:
+    static TiledBackingStorePolicy* instance();
+
+    void setMemoryBudget(int bytes);
+    int memoryBudget() const { return m_memoryBudget; }
+
+    void addView(WebView* view);
+    void removeView(WebView* view);
+    void viewVisibilityChanged(WebView* view);
+
+    void update(WebView* view, const QSizeF& viewportSize, const QSizeF& contentsSize,
+                const QPointF& velocity = QPointF(), const QPointF& flingDistance = QPointF());
+
+private:
+    TiledBackingStorePolicy();
+
+    struct Parameters {
+        Parameters();
+        bool operator==(const Parameters& other) const;
+
+        int tileCreationDelay;
+        QSizeF coverAreaMultiplier;
+        QSizeF keepAreaMultiplier;
+    };
+
+    struct ViewState {
+        QSizeF viewportSize;
+        QSizeF contentsSize;
+        QPointF velocity;
+        QPointF flingDistance;
+        Parameters applied;
+    };
+
+    void updateAll();
+    void apply(WebView* view, ViewState& state, int budget);
+    int inactiveViewCost(const ViewState& state) const;
+
+    QHash<WebView*, ViewState> m_views;
+    int m_memoryBudget;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "Settings.h"
 #include "HistoryStore.h"
 #include "KeypadWidget.h"
+#include "Preconnector.h"
 
 #include <QUrl>
 #include <QImage>
@@ -128,10 +129,17 @@ void ToolbarWidget::textEdited(const QString& newText)
     QString text = newText;
     if (m_urlEdit->selectionStart() > -1)
         text = newText.left(m_urlEdit->selectionStart());
+    // todo: make it async
+    QUrl matchedUrl;
+    QString match = HistoryStore::instance()->match(text, &matchedUrl);
+    // get the connection going while the user is still typing
+    if (match.isEmpty())
+        Preconnector::instance()->cancel();
+    else
+        Preconnector::instance()->preconnect(matchedUrl);
+
     // autocomplete only when adding text, not when deleting or backspacing
     if (text.size() > m_lastEnteredText.size()) {
-        // todo: make it async
-        QString match = HistoryStore::instance()->match(text);
         if (!match.isEmpty()) {
             m_urlEdit->setText(match);
             m_urlEdit->setCursorPosition(text.size());
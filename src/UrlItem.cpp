@@ -17,96 +17,195 @@
  * Boston, MA 02110-1301, USA.
  *
  */
-
 #include "UrlItem.h"
 
 #include <QDateTime>
-#include <QImage>
 #include <QDebug>
+#include "Helpers.h"
 #include "Settings.h"
+#include "ThumbnailCache.h"
+#include "ThumbnailWriter.h"
+
+class UrlItemData : public QSharedData {
+public:
+    UrlItemData()
+        : refcount(0)
+        , lastAccess(0)
+        , thumbnailChanged(false)
+    {
+    }
 
+    QUrl url;
+    QString title;
+    uint refcount;
+    uint lastAccess;
+    // see thumbnailLevels(), empty once the ThumbnailCache has them
+    QList<QImage> thumbnail;
+    QString thumbnailPath;
+    bool thumbnailChanged;
+};
+
+/*!
+  \class UrlItem is an implicitly shared history or bookmark entry.
+
+  Copies share the data until one of them is modified, the thumbnail
+  pixels are shared even then.
+*/
 UrlItem::UrlItem()
-    : m_refcount(0)
-    , m_lastAccess(0)
-    , m_thumbnail(0)
-    , m_thumbnailChanged(false)
+    : d(new UrlItemData)
 {
 }
 
-UrlItem::UrlItem(const QUrl& url, const QString& title, QImage* thumbnail)
-    : m_url(url)
-    , m_title(title)
-    , m_refcount(1)
-    , m_lastAccess(QDateTime::currentDateTime().toTime_t())
-    , m_thumbnail(thumbnail)
-    , m_thumbnailChanged(true)
+UrlItem::UrlItem(const QUrl& url, const QString& title, const QList<QImage>& thumbnailLevels)
+    : d(new UrlItemData)
 {
+    d->url = url;
+    d->title = title;
+    d->refcount = 1;
+    d->lastAccess = QDateTime::currentDateTime().toTime_t();
+    d->thumbnail = thumbnailLevels;
+    d->thumbnailChanged = true;
 }
 
 UrlItem::UrlItem(const UrlItem& item)
-    : m_url(item.m_url)
-    , m_title(item.m_title)
-    , m_refcount(item.m_refcount)
-    , m_lastAccess(item.m_lastAccess)
-    , m_thumbnail(item.m_thumbnail ? new QImage(*item.m_thumbnail) : 0)
-    , m_thumbnailPath(item.m_thumbnailPath)
-    , m_thumbnailChanged(item.m_thumbnailChanged)
+    : d(item.d)
 {
 }
 
 UrlItem::~UrlItem()
 {
-    delete m_thumbnail;
 }
 
 UrlItem& UrlItem::operator=(const UrlItem& other)
 {
-    m_url = other.m_url;
-    m_title = other.m_title;
-    m_refcount = other.m_refcount;
-    m_lastAccess = other.m_lastAccess;
-    m_thumbnailChanged = other.m_thumbnailChanged;
-    m_thumbnail = new QImage(*other.m_thumbnail);
-    m_thumbnailPath = other.m_thumbnailPath;
+    d = other.d;
     return *this;
 }
 
 bool UrlItem::operator==(const UrlItem& other) const
 {
-    return m_url == other.m_url;
+    return d->url == other.d->url;
 }
 
 bool UrlItem::operator<(const UrlItem& other) const
 {
-    return m_title.toLower() < other.m_title.toLower();
+    return d->title.toLower() < other.d->title.toLower();
 }
 
-void UrlItem::setThumbnail(QImage* thumbnail)
+QUrl UrlItem::url() const
 {
-    delete m_thumbnail;
+    return d->url;
+}
 
-    m_thumbnail = thumbnail;
-    m_thumbnailChanged = true;
+QString UrlItem::title() const
+{
+    return d->title;
+}
+
+uint UrlItem::refcount() const
+{
+    return d->refcount;
+}
+
+uint UrlItem::lastAccess() const
+{
+    return d->lastAccess;
+}
+
+QString UrlItem::thumbnailPath() const
+{
+    return d->thumbnailPath;
+}
+
+void UrlItem::setRefcount(uint refcount)
+{
+    d->refcount = refcount;
+}
+
+void UrlItem::setLastAccess(uint accessTime)
+{
+    d->lastAccess = accessTime;
+}
+
+void UrlItem::setThumbnail(const QList<QImage>& thumbnailLevels)
+{
+    d->thumbnail = thumbnailLevels;
+    d->thumbnailChanged = true;
+}
+
+bool UrlItem::hasThumbnail() const
+{
+    return !d->thumbnail.isEmpty() || !d->thumbnailPath.isEmpty();
+}
+
+/*!
+  Returns the smallest thumbnail level that covers \a size, the full
+  thumbnail if no size is given.
+*/
+QImage UrlItem::thumbnail(const QSize& size) const
+{
+    QList<QImage> levels = thumbnailLevels();
+    if (!size.isValid())
+        return levels.isEmpty() ? QImage() : levels.first();
+    return thumbnailLevel(levels, size);
+}
+
+/*!
+  Returns the thumbnail and its downscaled levels, loading them through
+  the ThumbnailCache if they are not in memory.
+*/
+QList<QImage> UrlItem::thumbnailLevels() const
+{
+    if (!d->thumbnail.isEmpty())
+        return d->thumbnail;
+    return ThumbnailCache::instance()->thumbnail(d->thumbnailPath);
+}
+
+/*!
+  Hands the thumbnail over to the ThumbnailCache once it is on disk.
+*/
+void UrlItem::releaseThumbnail()
+{
+    if (d->thumbnail.isEmpty() || d->thumbnailChanged || d->thumbnailPath.isEmpty())
+        return;
+    ThumbnailCache::instance()->insert(d->thumbnailPath, d->thumbnail);
+    d->thumbnail.clear();
+}
+
+/*!
+  Forgets the thumbnail file that could not be written, the thumbnail
+  stays in memory until the next one replaces it.
+*/
+void UrlItem::thumbnailSaveFailed()
+{
+    d->thumbnailPath.clear();
 }
 
 void UrlItem::externalize(QDataStream& out)
 {
-    if (m_thumbnail && m_thumbnailChanged) {
-        if (m_thumbnailPath.isEmpty())
-            m_thumbnailPath = QString::number(m_lastAccess + rand()) + ".png";
-        m_thumbnail->save(Settings::instance()->privatePath() + m_thumbnailPath);
+    // reading does not detach, only a changed thumbnail does
+    if (d.constData()->thumbnailChanged) {
+        if (d->thumbnail.isEmpty())
+            d->thumbnailChanged = false;
+        else {
+            // the levels are cheap to build again, only the full size one is saved
+            QString path = ThumbnailWriter::instance()->save(d->thumbnail.first());
+            // the writer is busy, keep the old thumbnail and try again next time
+            if (!path.isEmpty()) {
+                d->thumbnailPath = path;
+                d->thumbnailChanged = false;
+            }
+        }
     }
-    m_thumbnailChanged = false;
 
-    out << m_url.toString() << m_title << m_refcount << m_lastAccess << m_thumbnailPath;
+    const UrlItemData* data = d.constData();
+    out << data->url.toString() << data->title << data->refcount << data->lastAccess << data->thumbnailPath;
 }
 
 void UrlItem::internalize(QDataStream& in)
 {
     QString urlStr;
-    in >> urlStr >> m_title >> m_refcount >> m_lastAccess >> m_thumbnailPath;
-    m_url = urlStr;
-    if (!m_thumbnailPath.isEmpty())
-        m_thumbnail = new QImage(Settings::instance()->privatePath() + m_thumbnailPath);
+    in >> urlStr >> d->title >> d->refcount >> d->lastAccess >> d->thumbnailPath;
+    d->url = urlStr;
+    // the thumbnail is loaded when painted, a missing file is remembered by the ThumbnailCache
 }
-
@@ -17,7 +17,6 @@
  * Boston, MA 02110-1301, USA.
  *
  */
-
 #ifndef UrlItem_h_
 #define UrlItem_h_
 
@@ -25,13 +24,16 @@
 #include <QUrl>
 #include <QString>
 #include <QList>
+#include <QImage>
+#include <QSharedData>
+#include <QSharedDataPointer>
 
-class QImage;
+class UrlItemData;
 
 class UrlItem {
 public:
     UrlItem();
-    UrlItem(const QUrl& url, const QString& title, QImage* thumbnail);
+    UrlItem(const QUrl& url, const QString& title, const QList<QImage>& thumbnailLevels = QList<QImage>());
     UrlItem(const UrlItem& item);
     ~UrlItem();
 
@@ -39,30 +41,31 @@ public:
     bool operator<(const UrlItem& other) const;
     bool operator==(const UrlItem& other) const;
     
-    QUrl url() const { return m_url; }
-    QString title() const { return m_title; }
-    uint refcount() const { return m_refcount; }
-    uint lastAccess() const { return m_lastAccess; }
-    QImage* thumbnail() const { return m_thumbnail; }
+    QUrl url() const;
+    QString title() const;
+    uint refcount() const;
+    uint lastAccess() const;
+    bool hasThumbnail() const;
+    QImage thumbnail(const QSize& size = QSize()) const;
+    QList<QImage> thumbnailLevels() const;
+    QString thumbnailPath() const;
 
-    void setRefcount(uint refcount) { m_refcount = refcount; }
-    void setLastAccess(uint accessTime) { m_lastAccess = accessTime; }
-    void setThumbnail(QImage* thumbnail);
+    void setRefcount(uint refcount);
+    void setLastAccess(uint accessTime);
+    void setThumbnail(const QList<QImage>& thumbnailLevels);
+    void thumbnailSaveFailed();
+    void releaseThumbnail();
 
     void externalize(QDataStream& out);
     void internalize(QDataStream& in);
 
 private:
-    QUrl m_url;
-    QString m_title;
-    uint m_refcount;
-    uint m_lastAccess;
-    QImage* m_thumbnail;
-    QString m_thumbnailPath;
-    bool m_thumbnailChanged;
+    QSharedDataPointer<UrlItemData> d;
 };
 
+// a single shared pointer, QList keeps it inline and moves it with memmove
+Q_DECLARE_TYPEINFO(UrlItem, Q_MOVABLE_TYPE);
+
 typedef QList<UrlItem> UrlList;
 
 #endif
-
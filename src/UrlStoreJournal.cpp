@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "UrlStoreJournal.h"
+#include "Settings.h"
+
+#include <QDataStream>
+#include <QFile>
+
+static const uint s_journalVersion = 1;
+
+/*!
+  \class UrlStoreJournal appends the changes of a url store to a journal
+  file as they happen.
+
+  The store writes the whole list only once in a while, replaying the
+  journal on top of the last written list gives the current one. Change
+  records hold the whole item, so replaying them twice is harmless.
+*/
+UrlStoreJournal::UrlStoreJournal(const QString& fileName)
+    : m_fileName(fileName)
+    , m_records(0)
+{
+}
+
+QString UrlStoreJournal::path() const
+{
+    return Settings::instance()->privatePath() + m_fileName;
+}
+
+/*!
+  Applies the journal to \a list and returns the number of records
+  applied. Changed items not in the list are appended.
+*/
+int UrlStoreJournal::replay(UrlList& list)
+{
+    m_records = 0;
+    QFile journal(path());
+    if (!journal.open(QIODevice::ReadOnly))
+        return 0;
+
+    QDataStream in(&journal);
+    uint version;
+    in >> version;
+    if (version != s_journalVersion)
+        return 0;
+
+    while (!in.atEnd()) {
+        quint8 type;
+        in >> type;
+        UrlItem item;
+        QString url;
+        if (type == ChangeRecord)
+            item.internalize(in);
+        else
+            in >> url;
+        // a record cut short by a crash ends the journal
+        if (in.status() != QDataStream::Ok)
+            break;
+
+        int i = list.indexOf(type == ChangeRecord ? item : UrlItem(QUrl(url), QString()));
+        if (type == RemoveRecord) {
+            if (i != -1)
+                list.removeAt(i);
+        } else if (i != -1)
+            list[i] = item;
+        else
+            list.append(item);
+        m_records++;
+    }
+    return m_records;
+}
+
+/*!
+  Appends the current state of \a item, saving its thumbnail if needed.
+*/
+void UrlStoreJournal::itemChanged(UrlItem& item)
+{
+    QFile journal(path());
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
+        return;
+    QDataStream out(&journal);
+    if (!journal.size())
+        out << s_journalVersion;
+    out << quint8(ChangeRecord);
+    item.externalize(out);
+    m_records++;
+}
+
+void UrlStoreJournal::itemRemoved(const QUrl& url)
+{
+    QFile journal(path());
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
+        return;
+    QDataStream out(&journal);
+    if (!journal.size())
+        out << s_journalVersion;
+    out << quint8(RemoveRecord) << url.toString();
+    m_records++;
+}
+
+/*!
+  Empties the journal, to be called once the store has written the
+  whole list.
+*/
+void UrlStoreJournal::clear()
+{
+    QFile::remove(path());
+    m_records = 0;
+}
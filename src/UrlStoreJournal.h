@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef UrlStoreJournal_h_
+#define UrlStoreJournal_h_
+
+#include <QString>
+#include <QUrl>
+#include "UrlItem.h"
+
+class UrlStoreJournal {
+public:
+    explicit UrlStoreJournal(const QString& fileName);
+
+    int replay(UrlList& list);
+    int records() const { return m_records; }
+
+    void itemChanged(UrlItem& item);
+    void itemRemoved(const QUrl& url);
+    void clear();
+
+private:
+    enum RecordType {
+        ChangeRecord,
+        RemoveRecord
+    };
+
+    QString path() const;
+
+    QString m_fileName;
+    int m_records;
+};
+
+#endif
@@ -19,6 +19,7 @@
  */
 
 #include "WebView.h"
+#include "TiledBackingStorePolicy.h"
 #if USE_WEBKIT2
 #include <WebKit2/WKFrame.h>
 #endif
@@ -32,7 +33,6 @@ static QWKPage* createNewPageCallback(QWKPage* page)
 
 WebView::WebView(WKPageNamespaceRef namespaceRef, QGraphicsItem* parent)
     : QGraphicsWKView(namespaceRef, QGraphicsWKView::Tiled, parent)
-    , m_fpsTicks(0)
 {
     applyPageSettings();
     page()->setCreateNewPageFunction(createNewPageCallback);
@@ -40,26 +40,47 @@ WebView::WebView(WKPageNamespaceRef namespaceRef, QGraphicsItem* parent)
 #else
 WebView::WebView(QGraphicsItem* parent)
     : QGraphicsWebView(parent)
-    , m_fpsTicks(0)
 {
     applyPageSettings();
 }
 #endif
 
+WebView::~WebView()
+{
+    TiledBackingStorePolicy::instance()->removeView(this);
+}
+
 void WebView::paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget* w)
 {
-    m_fpsTicks++;
+    qint64 start = FrameStats::now();
 #if USE_WEBKIT2
     QGraphicsWKView::paint(p, option, w);
 #else
     QGraphicsWebView::paint(p, option, w);
+#endif
+    // offscreen renders, thumbnails and snapshots, have no widget and are not frames
+    if (!w)
+        return;
+    // the fps overlay repainting itself is not a frame of the page
+    if (!m_frameStatsExcludedRect.isEmpty() && m_frameStatsExcludedRect.contains(mapRectToScene(option->exposedRect)))
+        return;
+    m_frameStats.record(start, FrameStats::now() - start);
+}
+
+QVariant WebView::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+    // hidden views give their backing store memory to the visible one
+    if (change == ItemVisibleHasChanged)
+        TiledBackingStorePolicy::instance()->viewVisibilityChanged(this);
+#if USE_WEBKIT2
+    return QGraphicsWKView::itemChange(change, value);
+#else
+    return QGraphicsWebView::itemChange(change, value);
 #endif
 }
 
 void WebView::applyPageSettings()
 {
-    page()->setProperty("_q_TiledBackingStoreTileSize", QSize(256, 256));
-    page()->setProperty("_q_TiledBackingStoreTileCreationDelay", 25);
-    page()->setProperty("_q_TiledBackingStoreCoverAreaMultiplier", QSizeF(1.5, 1.5));
-    page()->setProperty("_q_TiledBackingStoreKeepAreaMultiplier", QSizeF(2., 2.5));
+    // tile size, creation delay, cover and keep areas
+    TiledBackingStorePolicy::instance()->addView(this);
 }
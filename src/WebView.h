@@ -30,6 +30,7 @@
 #endif
 #include "yberconfig.h"
 #include "PannableViewport.h"
+#include "FrameStats.h"
 
 class WebView : public
 #if USE_WEBKIT2
@@ -45,15 +46,23 @@ public:
 #else
     WebView(QGraphicsItem* parent = 0);
 #endif
+    ~WebView();
+
     void paint(QPainter* p, const QStyleOptionGraphicsItem* i, QWidget* w= 0);
-    unsigned int fpsTicks() const { return m_fpsTicks; }
+    const FrameStats& frameStats() const { return m_frameStats; }
+    // paints that only expose this scene rect are not counted as frames
+    void setFrameStatsExcludedRect(const QRectF& sceneRect) { m_frameStatsExcludedRect = sceneRect; }
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value);
 
 private:
     Q_DISABLE_COPY(WebView)
     void applyPageSettings();
 
 private:
-    unsigned int m_fpsTicks;
+    FrameStats m_frameStats;
+    QRectF m_frameStatsExcludedRect;
 };
 
 #endif
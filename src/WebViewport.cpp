@@ -25,6 +25,9 @@
 #include "WebView.h"
 #include "WebViewport.h"
 #include "WebViewportItem.h"
+#include "TiledBackingStorePolicy.h"
+#include "BackingStoreVisualizerWidget.h"
+#include "Settings.h"
 #include "qwebframe.h"
 #include "qgraphicswebview.h"
 #include "qwebelement.h"
@@ -71,6 +74,9 @@ WebViewport::WebViewport(QGraphicsItem* parent)
     , m_clickablePointItem(0)
 #endif
     , m_wasPanning(false)
+#if !USE_WEBKIT2
+    , m_backingStoreVisualizer(0)
+#endif
 {
     setFiltersChildEvents(true);
     // AutoRange is set to false, because MPannableViewport observes
@@ -489,18 +495,27 @@ void WebViewport::contentsSizeChangeCausedResize()
 void WebViewport::webPanningStarted()
 {
     m_wasPanning = true;
+    updateBackingStore();
 
-    // turn on and off tile creating while autoscrolling
-    if (m_panningState != WebViewport::Pushing) {
-        m_panningState = Pushing;
+    // tiles are frozen while the finger drags the page. Kinetic scrolling
+    // keeps creating them towards the landing point, the policy throttles it
+    PanningState panningState = isAutoScrolling() ? Prefetching : Pushing;
+    if (m_panningState != panningState) {
+        m_panningState = panningState;
         m_backingStoreUpdateEnableTimer.stop();
-        m_viewportWidget->disableContentUpdates();
+        if (panningState == Prefetching)
+            m_viewportWidget->enableContentUpdates();
+        else
+            m_viewportWidget->disableContentUpdates();
     }
 }
 
 void WebViewport::webPanningStopped()
 {
-    if (m_panningState != WebViewport::Inactive) {
+    updateBackingStore();
+    if (m_panningState == WebViewport::Prefetching)
+        m_panningState = Inactive;
+    else if (m_panningState != WebViewport::Inactive) {
         // m_viewportWidget->enableContentUpdates();
         m_panningState = Inactive;
         m_backingStoreUpdateEnableTimer.start(backingStoreUpdateEnableDelay);
@@ -644,6 +659,7 @@ void WebViewport::resizeEvent(QGraphicsSceneResizeEvent* event)
 {
     PannableViewport::resizeEvent(event);
     updateViewportItemSizeIfDimensionPreserved();
+    updateBackingStore();
 }
 
 void WebViewport::updateViewportItemSizeIfDimensionPreserved()
@@ -668,10 +684,33 @@ void WebViewport::updateViewportRange()
     // this must be done this way, because we cannot observe
     // the resize events of the item 
     setRange(QRectF(QPoint(), widget()->geometry().size()));
+    updateBackingStore();
+}
+
+void WebViewport::updateBackingStore()
+{
+    if (!m_viewportWidget->webView())
+        return;
+    TiledBackingStorePolicy::instance()->update(m_viewportWidget->webView(), size(), m_viewportWidget->size(), velocity(), flingDistance());
+#if !USE_WEBKIT2
+    if (m_backingStoreVisualizer)
+        m_backingStoreVisualizer->setVisibleRect(mapRectToItem(m_viewportWidget, rect()));
+#endif
 }
 
 void WebViewport::setWebView(WebView* webView)
 {
     m_viewportWidget->setWebView(webView);
+#if !USE_WEBKIT2
+    Settings* settings = Settings::instance();
+    delete m_backingStoreVisualizer;
+    m_backingStoreVisualizer = 0;
+    if (settings->tileVisualizationEnabled() || !settings->tileStatsLog().isEmpty()) {
+        m_backingStoreVisualizer = new BackingStoreVisualizerWidget(webView, m_viewportWidget);
+        m_backingStoreVisualizer->setZValue(1);
+        m_backingStoreVisualizer->setTilesVisible(settings->tileVisualizationEnabled());
+        m_backingStoreVisualizer->setLogFile(settings->tileStatsLog());
+    }
+#endif
     reset();
 }
@@ -37,6 +37,7 @@
 class WebViewportItem;
 class WebView;
 class LinkSelectionItem;
+class BackingStoreVisualizerWidget;
 class QGraphicsSceneMouseEvent;
 #if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
 class QGraphicsRectItem;
@@ -87,7 +88,8 @@ protected:
 
     enum PanningState {
         Inactive,
-        Pushing
+        Pushing,
+        Prefetching
     };
 
     void setPannedWidgetGeometry(const QRectF& r);
@@ -97,6 +99,7 @@ protected:
     void transferAnimStateToView();
     void updateViewportItemSizeIfDimensionPreserved();
     void updateViewportRange();
+    void updateBackingStore();
 
  private Q_SLOTS:
     void webPanningStarted();
@@ -121,6 +124,9 @@ protected:
     QRectF m_geomAnimEndValue;
 
     bool m_wasPanning;
+#if !USE_WEBKIT2
+    BackingStoreVisualizerWidget* m_backingStoreVisualizer;
+#endif
 
 #if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
     QGraphicsRectItem* m_searchRectItem;
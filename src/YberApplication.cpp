@@ -24,14 +24,19 @@
 #include "Helpers.h"
 #include "EnvHttpProxyFactory.h"
 #include "ApplicationWindow.h"
+#include "CookieJar.h"
+#include "DiskCache.h"
 
 #include <QUrl>
+#include <QNetworkAccessManager>
 #include <QNetworkProxyFactory>
 #include <QDebug>
 
+static const qint64 s_diskCacheSize = 20 * 1024 * 1024;
+
 YberApplication::YberApplication()
     : m_appwin(0)
-    , m_cookieJar(0)
+    , m_networkAccessManager(0)
 {
     bool useSystemConf = true;
 
@@ -54,7 +59,8 @@ YberApplication::YberApplication()
 
 YberApplication::~YberApplication()
 {
-    delete m_cookieJar;
+    // takes the cookie jar and the cache with it
+    delete m_networkAccessManager;
 }
 
 void YberApplication::startWithWindow(ApplicationWindow* appwin)
@@ -63,6 +69,9 @@ void YberApplication::startWithWindow(ApplicationWindow* appwin)
 
     if (!m_appwin) {
         m_appwin = appwin;
+        // benchmark renders offscreen, the window is never shown
+        if (Settings::instance()->benchmarkEnabled())
+            return;
         if (Settings::instance()->isFullScreen())
             m_appwin->showFullScreen();
         else
@@ -90,11 +99,30 @@ void YberApplication::createMainView(const QUrl& url)
         page->load(url);
 }
 
-CookieJar* YberApplication::cookieJar() const
+void YberApplication::runScrollBenchmark(const QList<QUrl>& pages)
 {
-    if (!m_cookieJar)
-        m_cookieJar = new CookieJar;
-    return m_cookieJar;
+    BrowsingView* page = new BrowsingView();
+#if USE_MEEGOTOUCH
+    page->appear(m_appwin, MSceneWindow::DestroyWhenDone);
+#else
+    page->appear(m_appwin);
+#endif
+    page->startScrollBenchmark(pages, Settings::instance()->benchmarkOutput());
+}
+
+/*!
+  Returns the network access manager shared by all the web pages, so that
+  the open connections, the host lookups and the ssl sessions get reused
+  from one page to another.
+*/
+QNetworkAccessManager* YberApplication::networkAccessManager() const
+{
+    if (!m_networkAccessManager) {
+        m_networkAccessManager = new QNetworkAccessManager;
+        m_networkAccessManager->setCookieJar(new CookieJar);
+        m_networkAccessManager->setCache(new DiskCache(Settings::instance()->diskCachePath(), s_diskCacheSize));
+    }
+    return m_networkAccessManager;
 }
 
 YberApplication* YberApplication::instance()
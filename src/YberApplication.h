@@ -24,7 +24,8 @@
 #include "yberconfig.h"
 
 #include "ApplicationWindow.h"
-#include "CookieJar.h"
+
+class QNetworkAccessManager;
 
 class YberApplication
 {
@@ -35,10 +36,11 @@ public:
     void startWithWindow(ApplicationWindow*);
 
     void createMainView(const QUrl& url);
+    void runScrollBenchmark(const QList<QUrl>& pages);
 
     ApplicationWindow* activeApplicationWindow() const { return m_appwin; }
 
-    CookieJar* cookieJar() const;
+    QNetworkAccessManager* networkAccessManager() const;
 
     static YberApplication* instance();
 
@@ -46,7 +48,7 @@ private:
     Q_DISABLE_COPY(YberApplication)
 
     ApplicationWindow *m_appwin;
-    mutable CookieJar* m_cookieJar;
+    mutable QNetworkAccessManager* m_networkAccessManager;
 };
 
 #endif
@@ -65,6 +65,8 @@
 
 void usage(const char* name);
 
+static const QSize s_benchmarkViewportSize(800, 480);
+
 
 #if USE_MEEGOTOUCH
 M_EXPORT
@@ -131,12 +133,23 @@ int main(int argc, char** argv)
             } else if (args.at(1) == "-v") {
                 settings->enableTileVisualization(true);
                 args.removeAt(1);
+            } else if (args.at(1) == "-s" && args.count() > 2) {
+                settings->setTileStatsLog(args.at(2));
+                args.removeAt(1);
+                args.removeAt(1);
             } else if (args.at(1) == "-a") {
                 settings->enableAutoComplete(false);
                 args.removeAt(1);
+            } else if (args.at(1) == "-n") {
+                settings->enableNetworkSuggest(true);
+                args.removeAt(1);
             } else if (args.at(1) == "-f") {
                 settings->enableFPS(true);
                 args.removeAt(1);
+            } else if (args.at(1) == "-b" && args.count() > 2) {
+                settings->setBenchmarkOutput(args.at(2));
+                args.removeAt(1);
+                args.removeAt(1);
             } else if (args.at(1) == "-?" || args.at(1) == "-h" || args.at(1) == "--help") {
                 usage(argv[0]);
                 return EXIT_SUCCESS;
@@ -155,16 +168,31 @@ int main(int argc, char** argv)
     QWebSettings::globalSettings()->setAttribute(QWebSettings::TiledBackingStoreEnabled, settings->tileCacheEnabled());
 
 
-    YberApplication::instance()->startWithWindow(window);
-    YberApplication::instance()->createMainView(urlFromUserInput(url));
-
-    for (int i = 2; i < args.count(); i++) {
-        if (args.at(i) != "-software")
-            YberApplication::instance()->createMainView(urlFromUserInput(args.at(i)));
+    if (settings->benchmarkEnabled()) {
+        // rest of the arguments are the pages to scroll, built-in fixtures by default
+        QList<QUrl> pages;
+        for (int i = 1; i < args.count(); i++)
+            pages.append(urlFromUserInput(args.at(i)));
+        if (pages.isEmpty()) {
+            pages.append(QUrl("qrc:/data/benchmark/text.html"));
+            pages.append(QUrl("qrc:/data/benchmark/layout.html"));
+        }
+        window->resize(s_benchmarkViewportSize);
+        YberApplication::instance()->startWithWindow(window);
+        YberApplication::instance()->runScrollBenchmark(pages);
+    } else {
+        YberApplication::instance()->startWithWindow(window);
+        YberApplication::instance()->createMainView(urlFromUserInput(url));
+
+        for (int i = 2; i < args.count(); i++) {
+            if (args.at(i) != "-software")
+                YberApplication::instance()->createMainView(urlFromUserInput(args.at(i)));
+        }
     }
 
 #if QTOPIA
-    window->showMaximized();
+    if (!settings->benchmarkEnabled())
+        window->showMaximized();
 #endif
     int retval = app->exec();
 
@@ -183,8 +211,12 @@ void usage(const char* name)
     s << " -g use glwidget as qgv viewport" << endl;
     s << " -c disable tile cache" << endl;
     s << " -v enable tile visualization" << endl;
+    s << " -s file append tile cache statistics to file every second" << endl;
     s << " -f show fps counter" << endl;
     s << " -a disable url autocomplete" << endl;
+    s << " -n fetch search suggestions from the network" << endl;
+    s << " -b file run the scroll benchmark offscreen on the given urls (built-in pages by default)" << endl;
+    s << "    and write frame timings to file (.json or .csv)" << endl;
     s << " -h|-?|--help help" << endl;
     s << endl;
     s << " use http_proxy env var to set http proxy" << endl;